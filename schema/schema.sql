@@ -111,7 +111,7 @@ CREATE TABLE `hdfs_inodes` (
   `subtree_locked` tinyint DEFAULT NULL,
   `file_stored_in_db` tinyint(4) NOT NULL DEFAULT '0',
   PRIMARY KEY (`partition_id`,`parent_id`,`name`),
-  KEY `pidex` (`parent_id`),
+  KEY `pidex` (`parent_id`,`name`),
   KEY `inode_idx` (`id`),
   KEY `c1` (`parent_id`,`partition_id`),
   KEY `c2` (`partition_id`,`parent_id`)
@@ -284,16 +284,20 @@ CREATE TABLE `hdfs_leases` (
   `holder` varchar(255) NOT NULL,
   `last_update` bigint(20) DEFAULT NULL,
   PRIMARY KEY (`holder_id`,`holder`),
-  KEY `update_idx` (`last_update`)
+  KEY `update_idx` (`last_update`,`holder_id`)
 ) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs COMMENT='NDB_TABLE=READ_BACKUP=1'
 /*!50100 PARTITION BY KEY (holder_id) */$$
 
 delimiter $$
 
 CREATE TABLE `hdfs_misreplicated_range_queue` (
-  `range` varchar(120) NOT NULL,
-  PRIMARY KEY (`range`)
-) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs$$
+  `nn_id` bigint(20) NOT NULL,
+  `start_index` bigint(20) NOT NULL,
+  `owner_id` bigint(20) NOT NULL DEFAULT '-1',
+  `lease_expiry` bigint(20) NOT NULL DEFAULT '0',
+  PRIMARY KEY (`nn_id`),
+  KEY `lease_idx` (`lease_expiry`)
+) ENGINE=ndbcluster DEFAULT CHARSET=latin1$$
 
 
 delimiter $$
@@ -338,7 +342,7 @@ CREATE TABLE `hdfs_replicas` (
   `storage_id` int(11) NOT NULL,
   `bucket_id` int(11) NOT NULL,
   PRIMARY KEY (`inode_id`,`block_id`,`storage_id`),
-  KEY `storage_idx` (`storage_id`),
+  KEY `storage_idx` (`storage_id`,`block_id`),
   KEY `hash_bucket_idx` (`bucket_id`)
 ) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs COMMENT='NDB_TABLE=READ_BACKUP=1'
 /*!50100 PARTITION BY KEY (inode_id) */$$
@@ -369,7 +373,7 @@ CREATE TABLE `hdfs_under_replicated_blocks` (
   `level` int(11) DEFAULT NULL,
   `timestamp` bigint(20) NOT NULL,
   PRIMARY KEY (`inode_id`,`block_id`),
-  KEY `level` (`level`,`timestamp`)
+  KEY `level` (`level`,`timestamp`,`inode_id`,`block_id`)
 ) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs COMMENT='NDB_TABLE=READ_BACKUP=1'
 /*!50100 PARTITION BY KEY (inode_id) */$$
 
@@ -421,7 +425,9 @@ CREATE TABLE `hdfs_encoding_status` (
   `lost_parity_blocks` int(11) DEFAULT 0,
   `revoked` tinyint DEFAULT 0,
   PRIMARY KEY (`inode_id`),
-  UNIQUE KEY `parity_inode_id` (`parity_inode_id`)
+  UNIQUE KEY `parity_inode_id` (`parity_inode_id`),
+  KEY `status_idx` (`status`,`status_modification_time`),
+  KEY `parity_status_idx` (`parity_status`,`parity_status_modification_time`)
 ) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs$$
 
 delimiter $$
@@ -669,6 +675,15 @@ CREATE TABLE `yarn_projects_daily_cost` (
 
 delimiter $$
 
+CREATE TABLE `yarn_quota_flushes` (
+  `flush_id` VARCHAR(36) NOT NULL,
+  `time` BIGINT NOT NULL,
+  PRIMARY KEY (`flush_id`),
+  KEY `time_idx` (`time`)
+) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs$$
+
+delimiter $$
+
 CREATE TABLE `yarn_containers_checkpoint` (
   `container_id` VARCHAR(255) NOT NULL,
   `checkpoint` BIGINT NOT NULL,
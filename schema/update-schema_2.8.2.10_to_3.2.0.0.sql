@@ -86,3 +86,22 @@ ALTER TABLE hdfs_retry_cache_entry DROP PRIMARY KEY;
 ALTER TABLE hdfs_retry_cache_entry ADD PRIMARY KEY (`client_id`,`call_id`,`epoch`) PARTITION BY KEY (`epoch`);
 
 insert into hdfs_variables (id, value) select 39, 0x0000000000000000 where (select count(*) from hdfs_variables)>0;
+
+ALTER TABLE `hdfs_replicas` DROP INDEX `storage_idx`, ADD INDEX `storage_idx` (`storage_id`,`block_id`);
+
+ALTER TABLE `hdfs_under_replicated_blocks` DROP INDEX `level`, ADD INDEX `level` (`level`,`timestamp`,`inode_id`,`block_id`);
+
+ALTER TABLE `hdfs_encoding_status` ADD INDEX `status_idx` (`status`,`status_modification_time`), ADD INDEX `parity_status_idx` (`parity_status`,`parity_status_modification_time`);
+
+ALTER TABLE `hdfs_leases` DROP INDEX `update_idx`, ADD INDEX `update_idx` (`last_update`,`holder_id`);
+
+ALTER TABLE `hdfs_inodes` DROP INDEX `pidex`, ADD INDEX `pidex` (`parent_id`,`name`);
+
+ALTER TABLE `hdfs_misreplicated_range_queue` ADD COLUMN `owner_id` bigint(20) NOT NULL DEFAULT '-1', ADD COLUMN `lease_expiry` bigint(20) NOT NULL DEFAULT '0', ADD INDEX `lease_idx` (`lease_expiry`);
+
+CREATE TABLE `yarn_quota_flushes` (
+  `flush_id` VARCHAR(36) NOT NULL,
+  `time` BIGINT NOT NULL,
+  PRIMARY KEY (`flush_id`),
+  KEY `time_idx` (`time`)
+) ENGINE=ndbcluster DEFAULT CHARSET=latin1 COLLATE=latin1_general_cs;
@@ -28,14 +28,19 @@ import io.hops.metadata.election.TablesDef;
 import io.hops.metadata.election.dal.HdfsLeDescriptorDataAccess;
 import io.hops.metadata.election.dal.YarnLeDescriptorDataAccess;
 import io.hops.metadata.hdfs.dal.*;
+import io.hops.metadata.ndb.cache.BlockLookUpCache;
+import io.hops.metadata.ndb.cache.StorageSnapshotCache;
+import io.hops.metadata.ndb.cache.UserGroupCache;
 import io.hops.metadata.ndb.dalimpl.configurationstore.ConfClusterJ;
 import io.hops.metadata.ndb.dalimpl.configurationstore.ConfMutationClusterJ;
 import io.hops.metadata.ndb.dalimpl.election.HdfsLeaderClusterj;
 import io.hops.metadata.ndb.dalimpl.election.YarnLeaderClusterj;
 import io.hops.metadata.ndb.dalimpl.hdfs.*;
 import io.hops.metadata.ndb.mysqlserver.MysqlServerConnector;
+import io.hops.metadata.ndb.wrapper.DTOArena;
 import io.hops.metadata.ndb.wrapper.HopsSession;
 import io.hops.metadata.ndb.wrapper.HopsTransaction;
+import io.hops.metadata.ndb.wrapper.WriteBatchStats;
 import io.hops.metadata.yarn.dal.AppProvenanceDataAccess;
 import io.hops.metadata.yarn.dal.quota.PriceMultiplicatorDataAccess;
 import io.hops.metadata.yarn.dal.quota.ProjectQuotaDataAccess;
@@ -58,6 +63,19 @@ public class ClusterjConnector implements StorageConnector<DBSession> {
   private DBSessionProvider dbSessionProvider = null;
   static ThreadLocal<DBSession> sessions = new ThreadLocal<>();
   static final Log LOG = LogFactory.getLog(ClusterjConnector.class);
+  public static final String BLOCK_LOOKUP_CACHE_SIZE =
+      "io.hops.block.lookup.cache.size";
+  public static final String BLOCK_LOOKUP_CACHE_TTL =
+      "io.hops.block.lookup.cache.ttl";
+  public static final String BLOCK_LOOKUP_CACHE_NEGATIVE_TTL =
+      "io.hops.block.lookup.cache.negative.ttl";
+  public static final String USER_GROUP_CACHE_SIZE =
+      "io.hops.user.group.cache.size";
+  public static final String USER_GROUP_CACHE_TTL =
+      "io.hops.user.group.cache.ttl";
+  public static final String STORAGE_CACHE_REFRESH_INTERVAL =
+      "io.hops.storage.cache.refresh.interval";
+  public static final String DTO_ARENA = "io.hops.session.dto.arena";
   private String clusterConnectString;
   private String databaseName;
   
@@ -89,6 +107,18 @@ public class ClusterjConnector implements StorageConnector<DBSession> {
         Integer.parseInt((String) conf.get("io.hops.session.reuse.count"));
     dbSessionProvider =
         new DBSessionProvider(conf, reuseCount, initialPoolSize);
+
+    BlockLookUpCache.configure(
+        Integer.parseInt(conf.getProperty(BLOCK_LOOKUP_CACHE_SIZE, "0")),
+        Long.parseLong(conf.getProperty(BLOCK_LOOKUP_CACHE_TTL, "60000")),
+        Long.parseLong(conf.getProperty(BLOCK_LOOKUP_CACHE_NEGATIVE_TTL, "0")));
+    UserGroupCache.configure(
+        Integer.parseInt(conf.getProperty(USER_GROUP_CACHE_SIZE, "0")),
+        Long.parseLong(conf.getProperty(USER_GROUP_CACHE_TTL, "60000")));
+    StorageSnapshotCache.configure(
+        Long.parseLong(conf.getProperty(STORAGE_CACHE_REFRESH_INTERVAL, "0")));
+    DTOArena.configure(DTOArena.Mode.valueOf(
+        conf.getProperty(DTO_ARENA, "off").trim().toUpperCase()));
     
     isInitialized = true;
   }
@@ -572,6 +602,13 @@ public class ClusterjConnector implements StorageConnector<DBSession> {
     dbSession.getSession().flush();
   }
 
+  /**
+   * @return the number of write operations sent per execute by this process
+   */
+  public WriteBatchStats getWriteBatchStats() {
+    return WriteBatchStats.getInstance();
+  }
+
   public String getClusterConnectString() {
     return clusterConnectString;
   }
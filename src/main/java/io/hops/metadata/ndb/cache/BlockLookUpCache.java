@@ -0,0 +1,268 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.cache;
+
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.nio.ByteBuffer;
+import java.nio.LongBuffer;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Bounded, off-heap block id to inode id cache in front of
+ * hdfs_block_lookup_table.
+ * <p/>
+ * The table is a 4-way set associative array of (blockId, value, expires)
+ * triples kept in a direct buffer, so it does not add to the heap or GC work
+ * whatever its size. A value >= 0 is an inode id, {@link #NOT_FOUND} marks a
+ * block that was not found.
+ * <p/>
+ * Local writes invalidate their entries from the DAL write path once their
+ * transaction has ended. A block deleted or moved to another inode by another
+ * namenode, by a truncate or a concat, is only seen once its entry expires,
+ * so positive entries are kept for a bounded, configurable time.
+ * <p/>
+ * A reader takes a {@link #stamp(long)} of the block before reading it from
+ * the database and passes it to {@link #put(long, long, long)}. Every
+ * invalidation bumps the stamps of its lock stripe, so a value read before a
+ * commit is not cached once the invalidation that follows the commit is done.
+ * <p/>
+ * Negative entries may be wrong as soon as another namenode creates the
+ * block, so they are only kept for a short, configurable time and are
+ * disabled by default.
+ */
+public class BlockLookUpCache {
+
+  static final Log LOG = LogFactory.getLog(BlockLookUpCache.class);
+
+  public static final long CACHE_MISS = Long.MIN_VALUE;
+  public static final long NOT_FOUND = -1L;
+
+  private static final int WAYS = 4;
+  private static final int LOCK_STRIPES = 1024;
+  private static final long EMPTY_KEY = 0L;
+  // key, value and expiry time of a slot
+  private static final int SLOT_LONGS = 3;
+
+  private static volatile BlockLookUpCache instance = null;
+
+  private final LongBuffer table;
+  private final int bucketMask;
+  private final Object[] locks;
+  // invalidation count of each lock stripe, guarded by the stripe lock
+  private final long[] epochs;
+  private final long ttl;
+  private final long negativeTtl;
+  private final AtomicLong victimCounter = new AtomicLong(0);
+  private final CacheStats stats = new CacheStats("block lookup");
+
+  BlockLookUpCache(int maxEntries, long ttl, long negativeTtl) {
+    int buckets = 1;
+    while (buckets * WAYS < maxEntries && buckets < (1 << 24)) {
+      buckets <<= 1;
+    }
+    this.bucketMask = buckets - 1;
+    this.ttl = ttl;
+    this.negativeTtl = negativeTtl;
+    this.table = ByteBuffer.allocateDirect(buckets * WAYS * SLOT_LONGS * 8)
+        .asLongBuffer();
+    this.locks = new Object[Math.min(LOCK_STRIPES, buckets)];
+    for (int i = 0; i < locks.length; i++) {
+      locks[i] = new Object();
+    }
+    this.epochs = new long[locks.length];
+  }
+
+  /**
+   * Sets up the process wide cache. A maxEntries of 0 disables it.
+   *
+   * @param ttl
+   *     how long, in ms, the inode of a block is remembered
+   * @param negativeTtl
+   *     how long, in ms, a block that was not found is remembered. 0
+   *     disables negative caching.
+   */
+  public static synchronized void configure(int maxEntries, long ttl,
+      long negativeTtl) {
+    if (maxEntries <= 0 || ttl <= 0) {
+      instance = null;
+      return;
+    }
+    instance = new BlockLookUpCache(maxEntries, ttl, negativeTtl);
+    LOG.info("Block lookup cache enabled, max entries: " + maxEntries +
+        " ttl: " + ttl + " ms negative ttl: " + negativeTtl + " ms");
+  }
+
+  /**
+   * @return the process wide cache or null if it is disabled
+   */
+  public static BlockLookUpCache getInstance() {
+    return instance;
+  }
+
+  /**
+   * @return the inode id of the block, {@link #NOT_FOUND} if the block is
+   * known not to exist or {@link #CACHE_MISS}
+   */
+  public long get(long blockId) {
+    if (blockId == EMPTY_KEY) {
+      stats.miss();
+      return CACHE_MISS;
+    }
+    int bucket = bucket(blockId);
+    int base = bucket * WAYS;
+    synchronized (lock(bucket)) {
+      for (int i = 0; i < WAYS; i++) {
+        int slot = (base + i) * SLOT_LONGS;
+        if (table.get(slot) == blockId) {
+          if (table.get(slot + 2) > System.currentTimeMillis()) {
+            long value = table.get(slot + 1);
+            if (value >= 0) {
+              stats.hit();
+            } else {
+              stats.negativeHit();
+            }
+            return value;
+          }
+          table.put(slot, EMPTY_KEY);
+          break;
+        }
+      }
+    }
+    stats.miss();
+    return CACHE_MISS;
+  }
+
+  /**
+   * @return the stamp to pass to {@link #put(long, long, long)} or
+   * {@link #putNotFound(long, long)} once the block is read
+   */
+  public long stamp(long blockId) {
+    int stripe = stripe(bucket(blockId));
+    synchronized (locks[stripe]) {
+      return epochs[stripe];
+    }
+  }
+
+  /**
+   * Caches the inode of the block unless the block was invalidated since the
+   * stamp was taken.
+   */
+  public void put(long blockId, long inodeId, long stamp) {
+    if (inodeId < 0) {
+      return;
+    }
+    store(blockId, inodeId, System.currentTimeMillis() + ttl, stamp);
+  }
+
+  public void putNotFound(long blockId, long stamp) {
+    if (negativeTtl <= 0) {
+      return;
+    }
+    store(blockId, NOT_FOUND, System.currentTimeMillis() + negativeTtl,
+        stamp);
+  }
+
+  public void invalidate(long blockId) {
+    if (blockId == EMPTY_KEY) {
+      return;
+    }
+    int bucket = bucket(blockId);
+    int base = bucket * WAYS;
+    int stripe = stripe(bucket);
+    synchronized (locks[stripe]) {
+      // also when the block is not cached, a reader may be about to cache it
+      epochs[stripe]++;
+      for (int i = 0; i < WAYS; i++) {
+        int slot = (base + i) * SLOT_LONGS;
+        if (table.get(slot) == blockId) {
+          table.put(slot, EMPTY_KEY);
+          stats.invalidation();
+          return;
+        }
+      }
+    }
+  }
+
+  public void clear() {
+    for (int i = 0; i < locks.length; i++) {
+      synchronized (locks[i]) {
+        epochs[i]++;
+        for (int bucket = i; bucket <= bucketMask; bucket += locks.length) {
+          for (int way = 0; way < WAYS; way++) {
+            table.put((bucket * WAYS + way) * SLOT_LONGS, EMPTY_KEY);
+          }
+        }
+      }
+    }
+  }
+
+  public CacheStats getStats() {
+    return stats;
+  }
+
+  private void store(long blockId, long value, long expires, long stamp) {
+    if (blockId == EMPTY_KEY) {
+      return;
+    }
+    int bucket = bucket(blockId);
+    int base = bucket * WAYS;
+    int stripe = stripe(bucket);
+    synchronized (locks[stripe]) {
+      if (epochs[stripe] != stamp) {
+        return;
+      }
+      int free = -1;
+      for (int i = 0; i < WAYS; i++) {
+        int slot = (base + i) * SLOT_LONGS;
+        long key = table.get(slot);
+        if (key == blockId) {
+          table.put(slot + 1, value);
+          table.put(slot + 2, expires);
+          return;
+        }
+        if (key == EMPTY_KEY && free == -1) {
+          free = slot;
+        }
+      }
+      if (free == -1) {
+        free = (base + (int) (victimCounter.getAndIncrement() & (WAYS - 1)))
+            * SLOT_LONGS;
+        stats.eviction();
+      }
+      table.put(free + 1, value);
+      table.put(free + 2, expires);
+      table.put(free, blockId);
+    }
+  }
+
+  private int bucket(long blockId) {
+    long h = blockId * 0x9E3779B97F4A7C15L;
+    return (int) (h ^ (h >>> 32)) & bucketMask;
+  }
+
+  private Object lock(int bucket) {
+    return locks[stripe(bucket)];
+  }
+
+  private int stripe(int bucket) {
+    return bucket & (locks.length - 1);
+  }
+}
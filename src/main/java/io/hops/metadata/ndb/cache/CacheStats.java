@@ -0,0 +1,100 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.cache;
+
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Hit/miss counters of the in-process metadata caches.
+ */
+public class CacheStats {
+
+  private final String name;
+  private final AtomicLong hits = new AtomicLong(0);
+  private final AtomicLong negativeHits = new AtomicLong(0);
+  private final AtomicLong misses = new AtomicLong(0);
+  private final AtomicLong evictions = new AtomicLong(0);
+  private final AtomicLong invalidations = new AtomicLong(0);
+
+  public CacheStats(String name) {
+    this.name = name;
+  }
+
+  void hit() {
+    hits.incrementAndGet();
+  }
+
+  void negativeHit() {
+    negativeHits.incrementAndGet();
+  }
+
+  void miss() {
+    misses.incrementAndGet();
+  }
+
+  void eviction() {
+    evictions.incrementAndGet();
+  }
+
+  void invalidation() {
+    invalidations.incrementAndGet();
+  }
+
+  public String getName() {
+    return name;
+  }
+
+  public long getHits() {
+    return hits.get();
+  }
+
+  public long getNegativeHits() {
+    return negativeHits.get();
+  }
+
+  public long getMisses() {
+    return misses.get();
+  }
+
+  public long getEvictions() {
+    return evictions.get();
+  }
+
+  public long getInvalidations() {
+    return invalidations.get();
+  }
+
+  /**
+   * @return the fraction of lookups answered by the cache, negative hits
+   * included
+   */
+  public double getHitRatio() {
+    long answered = hits.get() + negativeHits.get();
+    long total = answered + misses.get();
+    return total == 0 ? 0 : (double) answered / total;
+  }
+
+  @Override
+  public String toString() {
+    return name + " cache: hits=" + getHits() + " negativeHits=" +
+        getNegativeHits() + " misses=" + getMisses() + " evictions=" +
+        getEvictions() + " invalidations=" + getInvalidations() +
+        " hitRatio=" + String.format("%.3f", getHitRatio());
+  }
+}
@@ -0,0 +1,254 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.cache;
+
+import io.hops.exception.StorageException;
+import io.hops.metadata.hdfs.entity.Storage;
+import io.hops.metadata.hdfs.entity.StorageId;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.locks.ReentrantLock;
+
+/**
+ * Immutable, versioned in-memory copy of hdfs_storages and
+ * hdfs_storage_id_map.
+ * <p/>
+ * Lookups read the current {@link Snapshot} through a volatile reference and
+ * never lock. A new snapshot is built from full scans of both tables and
+ * swapped in when the current one is older than the refresh interval, when
+ * this process registers a storage, or when a lookup misses (a storage
+ * registered by another namenode). Only one thread rebuilds at a time, the
+ * others keep serving the previous snapshot while the current one is merely
+ * old.
+ * <p/>
+ * Writers invalidate once their transaction has ended, see
+ * {@link io.hops.metadata.ndb.wrapper.HopsSession#afterTransaction}. An
+ * invalidation that arrives while a rebuild is loading the tables marks the
+ * rebuilt snapshot stale, so it is replaced on the next lookup.
+ */
+public class StorageSnapshotCache {
+
+  static final Log LOG = LogFactory.getLog(StorageSnapshotCache.class);
+
+  /**
+   * Reads the full content of both tables.
+   */
+  public interface Loader {
+    Collection<Storage> loadStorages() throws StorageException;
+
+    Collection<StorageId> loadStorageIds() throws StorageException;
+  }
+
+  /**
+   * Content of both tables at a point in time.
+   */
+  public static class Snapshot {
+    private final long version;
+    private final long loadTime;
+    private final Storage[] storagesBySid;
+    private final List<Storage> storages;
+    private final Map<String, List<Storage>> storagesByHost;
+    private final Map<String, StorageId> storageIds;
+
+    Snapshot(long version, Collection<Storage> storages,
+        Collection<StorageId> storageIds) {
+      this.version = version;
+      this.loadTime = System.currentTimeMillis();
+      this.storages = Collections.unmodifiableList(
+          new ArrayList<>(storages));
+
+      int maxSid = -1;
+      for (Storage storage : storages) {
+        maxSid = Math.max(maxSid, storage.getStorageID());
+      }
+      this.storagesBySid = new Storage[maxSid + 1];
+      Map<String, List<Storage>> byHost = new HashMap<>();
+      for (Storage storage : storages) {
+        if (storage.getStorageID() >= 0) {
+          storagesBySid[storage.getStorageID()] = storage;
+        }
+        List<Storage> hostStorages = byHost.get(storage.getHostID());
+        if (hostStorages == null) {
+          hostStorages = new ArrayList<>();
+          byHost.put(storage.getHostID(), hostStorages);
+        }
+        hostStorages.add(storage);
+      }
+      for (Map.Entry<String, List<Storage>> e : byHost.entrySet()) {
+        e.setValue(Collections.unmodifiableList(e.getValue()));
+      }
+      this.storagesByHost = byHost;
+
+      Map<String, StorageId> ids = new HashMap<>(storageIds.size() * 2);
+      for (StorageId storageId : storageIds) {
+        ids.put(storageId.getStorageId(), storageId);
+      }
+      this.storageIds = ids;
+    }
+
+    public long getVersion() {
+      return version;
+    }
+
+    public long getLoadTime() {
+      return loadTime;
+    }
+
+    /**
+     * @return the storage or null if it is not in the snapshot
+     */
+    public Storage getStorage(int sid) {
+      return sid >= 0 && sid < storagesBySid.length ? storagesBySid[sid] :
+          null;
+    }
+
+    /**
+     * @return the storages of the host, empty if the host is unknown
+     */
+    public List<Storage> getStoragesOfHost(String hostId) {
+      List<Storage> hostStorages = storagesByHost.get(hostId);
+      return hostStorages == null ? Collections.<Storage>emptyList() :
+          hostStorages;
+    }
+
+    public List<Storage> getStorages() {
+      return storages;
+    }
+
+    /**
+     * @return the mapping of the storage uuid or null if it is not in the
+     * snapshot
+     */
+    public StorageId getStorageId(String storageId) {
+      return storageIds.get(storageId);
+    }
+
+    public Collection<StorageId> getStorageIds() {
+      return Collections.unmodifiableCollection(storageIds.values());
+    }
+  }
+
+  private static volatile StorageSnapshotCache instance = null;
+
+  private final long refreshInterval;
+  private final ReentrantLock rebuildLock = new ReentrantLock();
+  private final AtomicLong versions = new AtomicLong(0);
+  private final CacheStats stats = new CacheStats("storages");
+  private volatile Snapshot snapshot = null;
+  private volatile boolean stale = false;
+
+  StorageSnapshotCache(long refreshInterval) {
+    this.refreshInterval = refreshInterval;
+  }
+
+  /**
+   * Sets up the process wide cache. A refreshInterval of 0 disables it.
+   *
+   * @param refreshInterval
+   *     max age, in ms, of the snapshot before it is rebuilt
+   */
+  public static synchronized void configure(long refreshInterval) {
+    if (refreshInterval <= 0) {
+      instance = null;
+      return;
+    }
+    instance = new StorageSnapshotCache(refreshInterval);
+    LOG.info("Storage snapshot cache enabled, refresh interval: " +
+        refreshInterval + " ms");
+  }
+
+  /**
+   * @return the process wide cache or null if it is disabled
+   */
+  public static StorageSnapshotCache getInstance() {
+    return instance;
+  }
+
+  /**
+   * @return a snapshot that is no older than the refresh interval, unless
+   * another thread is already building its replacement
+   */
+  public Snapshot getSnapshot(Loader loader) throws StorageException {
+    Snapshot current = snapshot;
+    boolean wasStale = stale;
+    if (current != null && !wasStale &&
+        System.currentTimeMillis() - current.getLoadTime() < refreshInterval) {
+      return current;
+    }
+    if (current != null && !wasStale) {
+      // expired: one thread rebuilds, the others keep the old snapshot
+      if (!rebuildLock.tryLock()) {
+        return current;
+      }
+    } else {
+      rebuildLock.lock();
+    }
+    try {
+      if (snapshot != current) {
+        return snapshot;
+      }
+      stale = false;
+      Snapshot rebuilt = new Snapshot(versions.incrementAndGet(),
+          loader.loadStorages(), loader.loadStorageIds());
+      snapshot = rebuilt;
+      return rebuilt;
+    } catch (StorageException e) {
+      if (wasStale) {
+        stale = true;
+      }
+      throw e;
+    } finally {
+      rebuildLock.unlock();
+    }
+  }
+
+  /**
+   * Makes the next lookup rebuild the snapshot before answering.
+   */
+  public void invalidate() {
+    stale = true;
+    stats.invalidation();
+  }
+
+  public CacheStats getStats() {
+    return stats;
+  }
+
+  /**
+   * Records a lookup answered by the snapshot.
+   */
+  public void recordHit() {
+    stats.hit();
+  }
+
+  /**
+   * Records a lookup that the snapshot could not answer.
+   */
+  public void recordMiss() {
+    stats.miss();
+  }
+}
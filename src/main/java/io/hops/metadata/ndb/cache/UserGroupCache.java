@@ -0,0 +1,279 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.cache;
+
+import io.hops.metadata.hdfs.entity.Group;
+import io.hops.metadata.hdfs.entity.User;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Bounded, read-through cache of hdfs_users, hdfs_groups and
+ * hdfs_users_groups.
+ * <p/>
+ * Users and groups are cached both by id and by name, and the groups of a
+ * user are cached as a whole list. Caching the groups of a user also caches
+ * each of these groups, so the group lookups that follow a membership lookup
+ * do not go to the database.
+ * <p/>
+ * Local writes invalidate their entries once their transaction ends. Writes
+ * done by other namenodes are only seen once the entries expire, so entries
+ * are kept for a bounded, configurable time.
+ */
+public class UserGroupCache {
+
+  static final Log LOG = LogFactory.getLog(UserGroupCache.class);
+
+  private static volatile UserGroupCache instance = null;
+
+  private final long ttl;
+  private final LruMap<Integer, User> usersById;
+  private final LruMap<String, User> usersByName;
+  private final LruMap<Integer, Group> groupsById;
+  private final LruMap<String, Group> groupsByName;
+  private final LruMap<Integer, List<Group>> groupsByUser;
+  private final CacheStats stats = new CacheStats("users and groups");
+
+  UserGroupCache(int maxEntries, long ttl) {
+    this.ttl = ttl;
+    this.usersById = new LruMap<>(maxEntries);
+    this.usersByName = new LruMap<>(maxEntries);
+    this.groupsById = new LruMap<>(maxEntries);
+    this.groupsByName = new LruMap<>(maxEntries);
+    this.groupsByUser = new LruMap<>(maxEntries);
+  }
+
+  /**
+   * Sets up the process wide cache. A maxEntries of 0 disables it.
+   *
+   * @param maxEntries
+   *     max number of entries of each of the users, groups and memberships
+   *     maps
+   * @param ttl
+   *     how long, in ms, an entry is served before it is read again
+   */
+  public static synchronized void configure(int maxEntries, long ttl) {
+    if (maxEntries <= 0 || ttl <= 0) {
+      instance = null;
+      return;
+    }
+    instance = new UserGroupCache(maxEntries, ttl);
+    LOG.info("User and group cache enabled, max entries: " + maxEntries +
+        " ttl: " + ttl + " ms");
+  }
+
+  /**
+   * @return the process wide cache or null if it is disabled
+   */
+  public static UserGroupCache getInstance() {
+    return instance;
+  }
+
+  /**
+   * @return the cached user or null
+   */
+  public User getUser(int userId) {
+    return lookup(usersById, userId);
+  }
+
+  public User getUser(String userName) {
+    return lookup(usersByName, userName);
+  }
+
+  public Group getGroup(int groupId) {
+    return lookup(groupsById, groupId);
+  }
+
+  public Group getGroup(String groupName) {
+    return lookup(groupsByName, groupName);
+  }
+
+  /**
+   * @return the cached groups of the user or null
+   */
+  public List<Group> getGroupsForUser(int userId) {
+    List<Group> groups = lookup(groupsByUser, userId);
+    return groups == null ? null : new ArrayList<>(groups);
+  }
+
+  public void putUser(User user) {
+    long expires = System.currentTimeMillis() + ttl;
+    store(usersById, user.getId(), user, expires);
+    store(usersByName, user.getName(), user, expires);
+  }
+
+  public void putGroup(Group group) {
+    long expires = System.currentTimeMillis() + ttl;
+    store(groupsById, group.getId(), group, expires);
+    store(groupsByName, group.getName(), group, expires);
+  }
+
+  public void putGroupsForUser(int userId, List<Group> groups) {
+    long expires = System.currentTimeMillis() + ttl;
+    for (Group group : groups) {
+      store(groupsById, group.getId(), group, expires);
+      store(groupsByName, group.getName(), group, expires);
+    }
+    store(groupsByUser, userId,
+        Collections.unmodifiableList(new ArrayList<>(groups)), expires);
+  }
+
+  public void invalidateUser(int userId) {
+    usersById.remove(userId);
+    usersByName.removeIf(userId);
+    groupsByUser.remove(userId);
+    stats.invalidation();
+  }
+
+  /**
+   * Drops the group and every cached membership, as any user may have been
+   * a member of it.
+   */
+  public void invalidateGroup(int groupId) {
+    groupsById.remove(groupId);
+    groupsByName.removeIf(groupId);
+    groupsByUser.clear();
+    stats.invalidation();
+  }
+
+  public void invalidateGroupsForUser(int userId) {
+    groupsByUser.remove(userId);
+    stats.invalidation();
+  }
+
+  public void clear() {
+    usersById.clear();
+    usersByName.clear();
+    groupsById.clear();
+    groupsByName.clear();
+    groupsByUser.clear();
+  }
+
+  public CacheStats getStats() {
+    return stats;
+  }
+
+  private <K, V> V lookup(LruMap<K, V> map, K key) {
+    V value = map.get(key, System.currentTimeMillis());
+    if (value == null) {
+      stats.miss();
+    } else {
+      stats.hit();
+    }
+    return value;
+  }
+
+  private <K, V> void store(LruMap<K, V> map, K key, V value, long expires) {
+    if (key != null && value != null && map.put(key, value, expires)) {
+      stats.eviction();
+    }
+  }
+
+  private static class CachedValue<V> {
+    private final V value;
+    private final long expires;
+
+    CachedValue(V value, long expires) {
+      this.value = value;
+      this.expires = expires;
+    }
+  }
+
+  /**
+   * Access ordered map that drops its least recently used entry once it is
+   * full.
+   */
+  private static class LruMap<K, V> {
+    private final int maxEntries;
+    private final LinkedHashMap<K, CachedValue<V>> map;
+
+    LruMap(int maxEntries) {
+      this.maxEntries = maxEntries;
+      this.map = new LinkedHashMap<>(16, 0.75f, true);
+    }
+
+    synchronized V get(K key, long now) {
+      CachedValue<V> cached = map.get(key);
+      if (cached == null) {
+        return null;
+      }
+      if (cached.expires <= now) {
+        map.remove(key);
+        return null;
+      }
+      return cached.value;
+    }
+
+    /**
+     * @return true if an entry was evicted to make room for this one
+     */
+    synchronized boolean put(K key, V value, long expires) {
+      map.put(key, new CachedValue<>(value, expires));
+      if (map.size() > maxEntries) {
+        Iterator<K> eldest = map.keySet().iterator();
+        eldest.next();
+        eldest.remove();
+        return true;
+      }
+      return false;
+    }
+
+    synchronized void remove(K key) {
+      map.remove(key);
+    }
+
+    /**
+     * Removes the entries whose value has the given id or name.
+     */
+    synchronized void removeIf(Object idOrName) {
+      Iterator<Map.Entry<K, CachedValue<V>>> it = map.entrySet().iterator();
+      while (it.hasNext()) {
+        Object value = it.next().getValue().value;
+        if (matches(value, idOrName)) {
+          it.remove();
+        }
+      }
+    }
+
+    synchronized void clear() {
+      map.clear();
+    }
+
+    private static boolean matches(Object value, Object idOrName) {
+      if (value instanceof User) {
+        User user = (User) value;
+        return idOrName.equals(user.getId()) ||
+            idOrName.equals(user.getName());
+      }
+      if (value instanceof Group) {
+        Group group = (Group) value;
+        return idOrName.equals(group.getId()) ||
+            idOrName.equals(group.getName());
+      }
+      return false;
+    }
+  }
+}
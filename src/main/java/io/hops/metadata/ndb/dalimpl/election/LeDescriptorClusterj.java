@@ -79,6 +79,7 @@ public abstract class LeDescriptorClusterj
     LeaderDTO lTable = (LeaderDTO) dbSession.find(dto, keys);
     if (lTable != null) {
       LeDescriptor leader = createDescriptor(lTable);
+      dbSession.release(lTable);
       return leader;
     }
     return null;
@@ -99,8 +100,31 @@ public abstract class LeDescriptorClusterj
     HopsQueryBuilder qb = dbSession.getQueryBuilder();
     HopsQueryDomainType<LeaderDTO> dobj = qb.createQueryDefinition(dto);
     HopsQuery<LeaderDTO> query = dbSession.createQuery(dobj);
-    return createList(query.getResultList());
+    List<LeaderDTO> dtos = query.getResultList();
+    try {
+      return createList(dtos);
+    } finally {
+      dbSession.release(dtos);
+    }
+  }
 
+  /**
+   * Heartbeat of a node: writes only the counter column of its descriptor,
+   * with a single primary key update and no read, instead of rewriting the
+   * whole descriptor. Joins the transaction of the caller if there is one.
+   */
+  public void updateCounter(long id, int partitionVal, long counter)
+      throws StorageException {
+    HopsSession dbSession = connector.obtainSession();
+    LeaderDTO lTable = (LeaderDTO) dbSession.newInstance(dto);
+    try {
+      lTable.setId(id);
+      lTable.setPartitionVal(partitionVal);
+      lTable.setCounter(counter);
+      dbSession.updatePersistent(lTable);
+    } finally {
+      dbSession.release(lTable);
+    }
   }
 
   @Override
@@ -30,6 +30,7 @@ import io.hops.metadata.hdfs.dal.BlockInfoDataAccess;
 import io.hops.metadata.hdfs.entity.BlockInfo;
 import io.hops.metadata.hdfs.entity.BlockLookUp;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.BlockLookUpCache;
 import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
 import io.hops.metadata.ndb.wrapper.HopsPredicate;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
@@ -39,6 +40,7 @@ import io.hops.metadata.ndb.wrapper.HopsSession;
 
 import java.util.ArrayList;
 import java.util.Collection;
+import java.util.Collections;
 import java.util.List;
 import java.util.Set;
 
@@ -131,6 +133,9 @@ public class BlockInfoClusterj
         new ArrayList<>();
 
     HopsSession session = connector.obtainSession();
+    invalidateBlockLookUpCache(removed);
+    invalidateBlockLookUpCache(news);
+    invalidateBlockLookUpCache(modified);
     try {
       for (BlockInfo block : removed) {
         Object[] pk = new Object[2];
@@ -187,6 +192,43 @@ public class BlockInfoClusterj
     }
   }
 
+  /**
+   * Inserts a stream of new blocks, and their lookup rows, through several
+   * concurrent sessions, see {@link BulkLoader}. Blocks are partitioned on
+   * their inode id, the distribution key of the table. Add the blocks to the
+   * returned loader and call {@link BulkLoader#finish()} once done.
+   */
+  public BulkLoader<BlockInfo> bulkInsert(int threads, int batchSize,
+      int queueDepth) {
+    return new BulkLoader<BlockInfo>("Block Infos", threads, batchSize,
+        queueDepth) {
+      @Override
+      protected long partitionKey(BlockInfo block) {
+        return block.getInodeId();
+      }
+
+      @Override
+      protected void write(HopsSession session, List<BlockInfo> batch)
+          throws StorageException {
+        prepare(Collections.<BlockInfo>emptyList(), batch,
+            Collections.<BlockInfo>emptyList());
+      }
+    };
+  }
+
+  private static void invalidateBlockLookUpCache(Collection<BlockInfo> blocks)
+      throws StorageException {
+    if (BlockLookUpCache.getInstance() == null || blocks.isEmpty()) {
+      return;
+    }
+    long[] blockIds = new long[blocks.size()];
+    int i = 0;
+    for (BlockInfo block : blocks) {
+      blockIds[i++] = block.getBlockId();
+    }
+    BlockLookUpClusterj.invalidateCache(blockIds);
+  }
+
   @Override
   public BlockInfo findById(long blockId, long inodeId) throws StorageException {
     Object[] pk = new Object[2];
@@ -300,7 +342,28 @@ public class BlockInfoClusterj
     session.release(replicas);
     return ret;
   }
-  
+
+  /**
+   * Keyset paginated variant of
+   * {@link #findBlockInfosByStorageId(int, long, int)}: returns the blocks
+   * of at most limit replicas of the storage with a block id greater than
+   * afterBlockId, in block id order.
+   */
+  public List<BlockInfo> findBlockInfosByStorageIdAfter(int storageId,
+      long afterBlockId, int limit) throws StorageException {
+    HopsSession session = connector.obtainSession();
+    List<ReplicaClusterj.ReplicaDTO> replicas =
+        ReplicaClusterj.getReplicasPage(session, storageId, afterBlockId, limit);
+    long[] blockIds = new long[replicas.size()];
+    long[] inodeIds = new long[replicas.size()];
+    for (int i = 0; i < blockIds.length; i++) {
+      blockIds[i] = replicas.get(i).getBlockId();
+      inodeIds[i] = replicas.get(i).getINodeId();
+    }
+    session.release(replicas);
+    return readBlockInfoBatch(session, inodeIds, blockIds);
+  }
+
   @Override
   public List<BlockInfo> findBlockInfosBySids(List<Integer> sids) throws
       StorageException {
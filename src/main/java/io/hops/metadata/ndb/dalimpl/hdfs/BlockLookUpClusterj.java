@@ -28,7 +28,10 @@ import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.BlockLookUpDataAccess;
 import io.hops.metadata.hdfs.entity.BlockLookUp;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.BlockLookUpCache;
+import io.hops.metadata.ndb.cache.CacheStats;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.util.LongLongHashMap;
 
 import java.util.ArrayList;
 import java.util.Collection;
@@ -65,6 +68,8 @@ public class BlockLookUpClusterj
     List<BlockLookUpDTO> changes = new ArrayList<>();
     List<BlockLookUpDTO> deletions = new ArrayList<>();
 
+    invalidateCache(removed);
+    invalidateCache(modified);
     try {
       for (BlockLookUp block_lookup : removed) {
         BlockLookUpClusterj.BlockLookUpDTO bTable = session
@@ -90,14 +95,31 @@ public class BlockLookUpClusterj
 
   @Override
   public BlockLookUp findByBlockId(long blockId) throws StorageException {
+    BlockLookUpCache cache = BlockLookUpCache.getInstance();
+    long stamp = 0;
+    if (cache != null) {
+      long inodeId = cache.get(blockId);
+      if (inodeId == BlockLookUpCache.NOT_FOUND) {
+        return null;
+      } else if (inodeId != BlockLookUpCache.CACHE_MISS) {
+        return new BlockLookUp(blockId, inodeId);
+      }
+      stamp = cache.stamp(blockId);
+    }
     HopsSession session = connector.obtainSession();
     BlockLookUpClusterj.BlockLookUpDTO lookup =
         session.find(BlockLookUpClusterj.BlockLookUpDTO.class, blockId);
     if (lookup == null) {
+      if (cache != null) {
+        cache.putNotFound(blockId, stamp);
+      }
       return null;
     }
     BlockLookUp blu = createBlockInfo(lookup);
     session.release(lookup);
+    if (cache != null) {
+      cache.put(blu.getBlockId(), blu.getInodeId(), stamp);
+    }
     return blu;
   }
 
@@ -108,37 +130,72 @@ public class BlockLookUpClusterj
     return readINodeIdsByBlockIds(session, blockIds);
   }
 
+  /**
+   * @return the inode ids of the blocks, in the same order as blockIds, with
+   * NOT_FOUND_ROW for the blocks that do not exist. Only the blocks that are
+   * not in the block lookup cache are read from the database.
+   */
   protected static long[] readINodeIdsByBlockIds(final HopsSession session,
       final long[] blockIds) throws StorageException {
-    final List<BlockLookUpDTO> bldtos = new ArrayList<>();
-    final List<Long> inodeIds = new ArrayList<>();
+    final BlockLookUpCache cache = BlockLookUpCache.getInstance();
+    final long[] inodeIds = new long[blockIds.length];
+    final int[] toRead = new int[blockIds.length];
+    int nbToRead = 0;
+    for (int i = 0; i < blockIds.length; i++) {
+      long inodeId = cache == null ? BlockLookUpCache.CACHE_MISS :
+          cache.get(blockIds[i]);
+      if (inodeId == BlockLookUpCache.CACHE_MISS) {
+        toRead[nbToRead++] = i;
+      } else if (inodeId == BlockLookUpCache.NOT_FOUND) {
+        inodeIds[i] = NOT_FOUND_ROW;
+      } else {
+        inodeIds[i] = inodeId;
+      }
+    }
+    if (nbToRead == 0) {
+      return inodeIds;
+    }
+
+    final long[] stamps = new long[nbToRead];
+    if (cache != null) {
+      for (int j = 0; j < nbToRead; j++) {
+        stamps[j] = cache.stamp(blockIds[toRead[j]]);
+      }
+    }
+    final List<BlockLookUpDTO> bldtos = new ArrayList<>(nbToRead);
     try {
-      for (long blockId : blockIds) {
+      for (int j = 0; j < nbToRead; j++) {
         BlockLookUpDTO bldto =
-            session.newInstance(BlockLookUpDTO.class, blockId);
+            session.newInstance(BlockLookUpDTO.class, blockIds[toRead[j]]);
         bldto.setINodeId(NOT_FOUND_ROW);
         bldto = session.load(bldto);
         bldtos.add(bldto);
       }
       session.flush();
   
-      for (BlockLookUpDTO bld : bldtos) {
-        if (bld.getINodeId() != NOT_FOUND_ROW) {
-          inodeIds.add(bld.getINodeId());
-        } else {
+      for (int j = 0; j < nbToRead; j++) {
+        BlockLookUpDTO bld = bldtos.get(j);
+        long inodeId = bld.getINodeId();
+        if (inodeId == NOT_FOUND_ROW) {
           BlockLookUpDTO bldn =
               session.find(BlockLookUpDTO.class, bld.getBlockId());
           if (bldn != null) {
             //[M] BUG:
             //ClusterjConnector.LOG.error("xxx: Inode doesn't exists retries for " + bld.getBlockId() + " inodeId " + bld.getINodeId() + " at index " + i);
-            inodeIds.add(bldn.getINodeId());
+            inodeId = bldn.getINodeId();
             session.release(bldn);
+          }
+        }
+        inodeIds[toRead[j]] = inodeId;
+        if (cache != null) {
+          if (inodeId == NOT_FOUND_ROW) {
+            cache.putNotFound(bld.getBlockId(), stamps[j]);
           } else {
-            inodeIds.add(NOT_FOUND_ROW);
+            cache.put(bld.getBlockId(), inodeId, stamps[j]);
           }
         }
       }
-      return Longs.toArray(inodeIds);
+      return inodeIds;
     }finally {
       session.release(bldtos);
     }
@@ -147,45 +204,81 @@ public class BlockLookUpClusterj
   @Override
   public Map<Long, List<Long>> getINodeIdsForBlockIds(final long[] blockIds) throws StorageException {
     final HopsSession session = connector.obtainSession();
-    final List<BlockLookUpDTO> bldtos = new ArrayList<>();
+    final long[] inodeIds = readINodeIdsByBlockIds(session, blockIds);
     final Map<Long, List<Long>> InodeToBlockIdsMap = new HashMap<>(blockIds.length);
-    try {
-      for (long blockId : blockIds) {
-        BlockLookUpDTO bldto =
-            session.newInstance(BlockLookUpDTO.class, blockId);
-        bldto.setINodeId(NOT_FOUND_ROW);
-        bldto = session.load(bldto);
-        bldtos.add(bldto);
+    for (int i = 0; i < blockIds.length; i++) {
+      if (inodeIds[i] != NOT_FOUND_ROW) {
+        addBlockId(InodeToBlockIdsMap, inodeIds[i], blockIds[i]);
       }
-      session.flush();
-  
-      for (BlockLookUpDTO bld : bldtos) {
-        if (bld.getINodeId() != NOT_FOUND_ROW) {
-          addBlockId(InodeToBlockIdsMap, bld);
-        } else {
-          BlockLookUpDTO bldn =
-              session.find(BlockLookUpDTO.class, bld.getBlockId());
-          if (bldn != null) {
-            //[M] BUG:
-            //ClusterjConnector.LOG.error("xxx: Inode doesn't exists retries for " + bld.getBlockId() + " inodeId " + bld.getINodeId() + " at index " + i);
-            addBlockId(InodeToBlockIdsMap, bld);
-            session.release(bldn);
-          } 
-        }
+    }
+    return InodeToBlockIdsMap;
+  }
+
+  /**
+   * Drops the cached entries of blocks whose lookup row is written or
+   * deleted by this process, once the current transaction has ended.
+   */
+  static void invalidateCache(Collection<BlockLookUp> lookups)
+      throws StorageException {
+    if (BlockLookUpCache.getInstance() == null || lookups.isEmpty()) {
+      return;
+    }
+    long[] blockIds = new long[lookups.size()];
+    int i = 0;
+    for (BlockLookUp lookup : lookups) {
+      blockIds[i++] = lookup.getBlockId();
+    }
+    invalidateCache(blockIds);
+  }
+
+  static void invalidateCache(final long[] blockIds) throws StorageException {
+    final BlockLookUpCache cache = BlockLookUpCache.getInstance();
+    if (cache == null || blockIds.length == 0) {
+      return;
+    }
+    ClusterjConnector.getInstance().obtainSession().afterTransaction(
+        new Runnable() {
+          @Override
+          public void run() {
+            for (long blockId : blockIds) {
+              cache.invalidate(blockId);
+            }
+          }
+        });
+  }
+
+  public static CacheStats getCacheStats() {
+    BlockLookUpCache cache = BlockLookUpCache.getInstance();
+    return cache == null ? null : cache.getStats();
+  }
+
+  /**
+   * Bulk variant of {@link #getINodeIdsForBlockIds(long[])}. Returns a
+   * blockId to inodeId map without boxing, blocks that are not found are left
+   * out.
+   */
+  public LongLongHashMap getINodeIdsForBlockIdsBulk(final long[] blockIds)
+      throws StorageException {
+    final HopsSession session = connector.obtainSession();
+    final long[] inodeIds = readINodeIdsByBlockIds(session, blockIds);
+    final LongLongHashMap blockToINodeMap =
+        new LongLongHashMap(blockIds.length);
+    for (int i = 0; i < blockIds.length; i++) {
+      if (inodeIds[i] != NOT_FOUND_ROW) {
+        blockToINodeMap.put(blockIds[i], inodeIds[i]);
       }
-      return InodeToBlockIdsMap;
-    }finally {
-      session.release(bldtos);
     }
+    return blockToINodeMap;
   }
-  
-  private void addBlockId(Map<Long, List<Long>> map, BlockLookUpDTO bld){
-    List<Long> blockIds = map.get(bld.getINodeId());
+
+  private void addBlockId(Map<Long, List<Long>> map, long inodeId,
+      long blockId) {
+    List<Long> blockIds = map.get(inodeId);
     if(blockIds==null){
       blockIds = new ArrayList<>();
-      map.put(bld.getINodeId(), blockIds);
+      map.put(inodeId, blockIds);
     }
-    blockIds.add(bld.getBlockId());
+    blockIds.add(blockId);
   }
   
   protected static BlockLookUp createBlockInfo(
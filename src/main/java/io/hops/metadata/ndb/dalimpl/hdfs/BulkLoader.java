@@ -0,0 +1,279 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.dalimpl.hdfs;
+
+import io.hops.exception.StorageException;
+import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.wrapper.HopsSession;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Writes a large stream of rows through several sessions at once, for bulk
+ * ingest at startup or import time.
+ * <p/>
+ * Rows are partitioned on their distribution key, so that all the rows of a
+ * key are written by the same writer thread, and grouped in batches of
+ * batchSize rows. Each batch is written in its own transaction, that is one
+ * execute per batch. Every writer has a bounded queue of queueDepth batches:
+ * once it is full {@link #add(Object)} blocks until the writer catches up.
+ * <p/>
+ * {@link #add(Object)} and {@link #finish()} must be called from a single
+ * producer thread. Every loader must end with {@link #finish()} or
+ * {@link #abort()}, also when {@link #add(Object)} throws, otherwise its
+ * writer threads and their sessions are never freed.
+ */
+public abstract class BulkLoader<R> {
+  static final Log LOG = LogFactory.getLog(BulkLoader.class);
+
+  private static final List<?> END_OF_STREAM = Collections.emptyList();
+  private static final long OFFER_TIMEOUT_MS = 100;
+
+  private final String name;
+  private final int batchSize;
+  private final ExecutorService executor;
+  private final List<BlockingQueue<List<R>>> queues;
+  private final List<List<R>> pending;
+  private final List<Future<Long>> writers;
+  private final AtomicLong rowsWritten = new AtomicLong(0);
+  private final long startTime;
+  private volatile StorageException failure = null;
+  private long endTime = 0;
+
+  protected BulkLoader(final String name, int threads, int batchSize,
+      int queueDepth) {
+    if (threads <= 0 || batchSize <= 0 || queueDepth <= 0) {
+      throw new IllegalArgumentException("threads, batch size and queue " +
+          "depth must be positive");
+    }
+    this.name = name;
+    this.batchSize = batchSize;
+    this.executor = Executors.newFixedThreadPool(threads,
+        new ThreadFactory() {
+          private int count = 0;
+
+          @Override
+          public synchronized Thread newThread(Runnable r) {
+            Thread thread = new Thread(r, name + " Bulk Loader " + count++);
+            thread.setDaemon(true);
+            return thread;
+          }
+        });
+    this.queues = new ArrayList<>(threads);
+    this.pending = new ArrayList<>(threads);
+    this.writers = new ArrayList<>(threads);
+    for (int i = 0; i < threads; i++) {
+      BlockingQueue<List<R>> queue = new ArrayBlockingQueue<>(queueDepth);
+      queues.add(queue);
+      pending.add(new ArrayList<R>(batchSize));
+      writers.add(executor.submit(new Writer(queue)));
+    }
+    this.startTime = System.currentTimeMillis();
+  }
+
+  /**
+   * @return the distribution key of the row
+   */
+  protected abstract long partitionKey(R row);
+
+  /**
+   * Writes one batch of rows in the current transaction of the session.
+   */
+  protected abstract void write(HopsSession session, List<R> batch)
+      throws StorageException;
+
+  /**
+   * Queues a row, blocking while the writer of its partition is behind.
+   *
+   * @throws StorageException
+   *     if a writer has failed
+   */
+  public void add(R row) throws StorageException {
+    int writer = (int) (mix(partitionKey(row)) % queues.size());
+    List<R> batch = pending.get(writer);
+    batch.add(row);
+    if (batch.size() >= batchSize) {
+      pending.set(writer, new ArrayList<R>(batchSize));
+      enqueue(writer, batch);
+    }
+  }
+
+  /**
+   * Writes the remaining rows and waits for all the writers to finish.
+   *
+   * @return the number of rows written
+   * @throws StorageException
+   *     the first failure of any writer
+   */
+  public long finish() throws StorageException {
+    try {
+      for (int i = 0; i < queues.size(); i++) {
+        if (!pending.get(i).isEmpty()) {
+          enqueue(i, pending.get(i));
+          pending.set(i, new ArrayList<R>(0));
+        }
+        enqueue(i, endOfStream());
+      }
+      for (Future<Long> writer : writers) {
+        try {
+          writer.get();
+        } catch (ExecutionException e) {
+          fail(e.getCause());
+        }
+      }
+    } catch (InterruptedException e) {
+      Thread.currentThread().interrupt();
+      throw new StorageException(e);
+    } finally {
+      executor.shutdownNow();
+      endTime = System.currentTimeMillis();
+    }
+    if (failure != null) {
+      throw failure;
+    }
+    LOG.info(name + " bulk load wrote " + rowsWritten.get() + " rows in " +
+        (endTime - startTime) + " ms, " + (long) getRowsPerSecond() +
+        " rows/s");
+    return rowsWritten.get();
+  }
+
+  /**
+   * Stops the writers without writing the rows that are still queued. The
+   * batch being written, if any, is rolled back.
+   */
+  public void abort() {
+    fail(new StorageException(name + " bulk load aborted"));
+    executor.shutdownNow();
+    if (endTime == 0) {
+      endTime = System.currentTimeMillis();
+    }
+  }
+
+  public long getRowsWritten() {
+    return rowsWritten.get();
+  }
+
+  /**
+   * @return the write rate since the loader was created, up to the end of
+   * {@link #finish()}
+   */
+  public double getRowsPerSecond() {
+    long end = endTime == 0 ? System.currentTimeMillis() : endTime;
+    long elapsed = Math.max(1, end - startTime);
+    return rowsWritten.get() * 1000.0 / elapsed;
+  }
+
+  private void enqueue(int writer, List<R> batch) throws StorageException {
+    BlockingQueue<List<R>> queue = queues.get(writer);
+    try {
+      while (!queue.offer(batch, OFFER_TIMEOUT_MS, TimeUnit.MILLISECONDS)) {
+        if (failure != null) {
+          throw failure;
+        }
+      }
+    } catch (InterruptedException e) {
+      Thread.currentThread().interrupt();
+      throw new StorageException(e);
+    }
+    if (failure != null) {
+      throw failure;
+    }
+  }
+
+  private void fail(Throwable t) {
+    if (failure == null) {
+      failure = t instanceof StorageException ? (StorageException) t :
+          new StorageException(t);
+    }
+  }
+
+  @SuppressWarnings("unchecked")
+  private List<R> endOfStream() {
+    return (List<R>) END_OF_STREAM;
+  }
+
+  private static long mix(long key) {
+    long h = key * 0x9E3779B97F4A7C15L;
+    return (h ^ (h >>> 32)) & Long.MAX_VALUE;
+  }
+
+  /**
+   * Drains one queue with its own session, one transaction per batch.
+   */
+  private class Writer implements Callable<Long> {
+    private final BlockingQueue<List<R>> queue;
+
+    Writer(BlockingQueue<List<R>> queue) {
+      this.queue = queue;
+    }
+
+    @Override
+    public Long call() throws Exception {
+      ClusterjConnector connector = ClusterjConnector.getInstance();
+      boolean error = false;
+      long written = 0;
+      try {
+        HopsSession session = connector.obtainSession();
+        List<R> batch;
+        while ((batch = queue.take()) != END_OF_STREAM) {
+          if (failure != null) {
+            // keep draining so that the producer does not block
+            continue;
+          }
+          session.currentTransaction().begin();
+          try {
+            write(session, batch);
+            session.currentTransaction().commit();
+          } catch (Throwable t) {
+            // also on runtime exceptions, a session must not go back to the
+            // pool with an active transaction
+            if (session.currentTransaction().isActive()) {
+              session.currentTransaction().rollback();
+            }
+            throw t;
+          }
+          written += batch.size();
+          rowsWritten.addAndGet(batch.size());
+        }
+        return written;
+      } catch (Throwable t) {
+        // the producer only stops waiting on a full queue once failure is set
+        error = true;
+        fail(t);
+        throw t;
+      } finally {
+        connector.returnSession(error);
+      }
+    }
+  }
+}
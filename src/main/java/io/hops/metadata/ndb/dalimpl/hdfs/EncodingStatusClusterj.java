@@ -45,8 +45,6 @@ import java.sql.ResultSet;
 import java.sql.SQLException;
 import java.util.ArrayList;
 import java.util.Collection;
-import java.util.Collections;
-import java.util.Comparator;
 import java.util.List;
 
 public class EncodingStatusClusterj implements TablesDef.EncodingStatusTableDef,
@@ -305,22 +303,9 @@ public class EncodingStatusClusterj implements TablesDef.EncodingStatusTableDef,
   @Override
   public Collection<EncodingStatus> findRequestedEncodings(int limit)
       throws StorageException {
-    Collection<EncodingStatus> normalEncodings = findWithStatus(
-        EncodingStatus.Status.ENCODING_REQUESTED.ordinal(), limit);
-    Collection<EncodingStatus> copyEncodings = findWithStatus(
-        EncodingStatus.Status.COPY_ENCODING_REQUESTED.ordinal(), limit);
-    ArrayList<EncodingStatus> requests = new ArrayList<>(limit);
-    requests.addAll(normalEncodings);
-    requests.addAll(copyEncodings);
-    Collections.sort(requests, new Comparator<EncodingStatus>() {
-      @Override
-      public int compare(EncodingStatus o1, EncodingStatus o2) {
-        return o1.getStatusModificationTime()
-            .compareTo(o2.getStatusModificationTime());
-      }
-    });
-    return requests.subList(0, requests.size() < limit ?
-        requests.size() : limit);
+    return findWithStatuses(limit,
+        EncodingStatus.Status.ENCODING_REQUESTED.ordinal(),
+        EncodingStatus.Status.COPY_ENCODING_REQUESTED.ordinal());
   }
 
   @Override
@@ -397,7 +382,7 @@ public class EncodingStatusClusterj implements TablesDef.EncodingStatusTableDef,
       throws StorageException {
     final String queryString =
         "SELECT * FROM %s WHERE %s=%s AND %s!=%s AND %s!=%s ORDER BY %s ASC LIMIT %s";
-    String query = String.format(STATUS_QUERY, TABLE_NAME, PARITY_STATUS,
+    String query = String.format(queryString, TABLE_NAME, PARITY_STATUS,
         EncodingStatus.ParityStatus.REPAIR_REQUESTED.ordinal(), STATUS,
         EncodingStatus.Status.REPAIR_ACTIVE.ordinal(), STATUS,
         EncodingStatus.Status.REPAIR_FAILED.ordinal(),
@@ -540,6 +525,34 @@ public class EncodingStatusClusterj implements TablesDef.EncodingStatusTableDef,
     return find(query);
   }
 
+  private static final String ORDERED_STATUS_SUBQUERY =
+      "(SELECT * FROM %s WHERE %s=%s ORDER BY %s ASC LIMIT %s)";
+
+  /**
+   * Returns the first limit rows, by status modification time, having any of
+   * the given statuses. Each status is read with an ordered scan of the
+   * (status, status_modification_time) index that stops after limit rows,
+   * and the scans are merged on the MySQL server, so at most limit rows are
+   * sent back and nothing has to be sorted here.
+   */
+  private List<EncodingStatus> findWithStatuses(long limit, int... statuses)
+      throws StorageException {
+    if (statuses.length == 1) {
+      return findWithStatus(statuses[0], limit);
+    }
+    StringBuilder query = new StringBuilder();
+    for (int i = 0; i < statuses.length; i++) {
+      if (i > 0) {
+        query.append(" UNION ALL ");
+      }
+      query.append(String.format(ORDERED_STATUS_SUBQUERY, TABLE_NAME, STATUS,
+          statuses[i], STATUS_MODIFICATION_TIME, limit));
+    }
+    query.append(" ORDER BY ").append(STATUS_MODIFICATION_TIME)
+        .append(" ASC LIMIT ").append(limit);
+    return find(query.toString());
+  }
+
   private List<EncodingStatus> find(String query) throws StorageException {
     ArrayList<EncodingStatus> resultList;
     PreparedStatement s = null;
@@ -28,6 +28,7 @@ import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.GroupDataAccess;
 import io.hops.metadata.hdfs.entity.Group;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.UserGroupCache;
 import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
@@ -60,20 +61,41 @@ public class GroupClusterj implements TablesDef.GroupsTableDef, GroupDataAccess<
 
   @Override
   public Group getGroup(final int groupId) throws StorageException {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      Group cached = cache.getGroup(groupId);
+      if (cached != null) {
+        return cached;
+      }
+    }
     HopsSession session = connector.obtainSession();
     GroupDTO dto = session.find(GroupDTO.class, groupId);
     Group group = null;
     if(dto != null) {
       group = new Group(dto.getId(), dto.getName());
       session.release(dto);
+      if (cache != null) {
+        cache.putGroup(group);
+      }
     }
     return group;
   }
 
   @Override
   public Group getGroup(final String groupName) throws StorageException {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      Group cached = cache.getGroup(groupName);
+      if (cached != null) {
+        return cached;
+      }
+    }
     HopsSession session = connector.obtainSession();
-    return getGroup(session, groupName);
+    Group group = getGroup(session, groupName);
+    if (cache != null && group != null) {
+      cache.putGroup(group);
+    }
+    return group;
   }
 
 
@@ -90,7 +112,7 @@ public class GroupClusterj implements TablesDef.GroupsTableDef, GroupDataAccess<
   }
 
   @Override
-  public void removeGroup(int groupId) throws StorageException {
+  public void removeGroup(final int groupId) throws StorageException {
     HopsSession session = connector.obtainSession();
     GroupDTO dto = null;
     try {
@@ -99,6 +121,15 @@ public class GroupClusterj implements TablesDef.GroupsTableDef, GroupDataAccess<
     }finally {
       session.release(dto);
     }
+    final UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      session.afterTransaction(new Runnable() {
+        @Override
+        public void run() {
+          cache.invalidateGroup(groupId);
+        }
+      });
+    }
   }
 
   static List<Group> convert(HopsSession session, Collection<GroupDTO>
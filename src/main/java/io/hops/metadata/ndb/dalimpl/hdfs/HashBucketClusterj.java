@@ -88,6 +88,70 @@ public class HashBucketClusterj
     return convertAndRelease(session, query.getResultList());
   }
   
+  /**
+   * Compares the bucket hashes reported for a storage with the stored ones
+   * and returns the ids of the buckets that differ, so that only the replicas
+   * of those buckets have to be read. reportedHashes is indexed by bucket id.
+   * A bucket without a row is compared against an all zero hash, the value of
+   * an empty bucket. A stored, non empty bucket whose id is not reported is
+   * mismatched. Stored rows are released as soon as they are compared, no
+   * HashBucket is created.
+   *
+   * @return the mismatched bucket ids in increasing order
+   */
+  public int[] findMismatchedBuckets(int storageId, byte[][] reportedHashes)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<HashBucketDTO> dobj =
+            qb.createQueryDefinition(HashBucketDTO.class);
+    HopsPredicate pred1 = dobj.get("storageId").equal(dobj.param("storageIdParam"));
+    dobj.where(pred1);
+    HopsQuery<HashBucketDTO> query = session.createQuery(dobj);
+    query.setParameter("storageIdParam", storageId);
+
+    boolean[] seen = new boolean[reportedHashes.length];
+    List<Integer> mismatched = new ArrayList<>();
+    for (HashBucketDTO dto : query.getResultList()) {
+      int bucketId = dto.getBucketId();
+      if (bucketId >= 0 && bucketId < reportedHashes.length) {
+        seen[bucketId] = true;
+        if (!Arrays.equals(dto.getHash(), reportedHashes[bucketId])) {
+          mismatched.add(bucketId);
+        }
+      } else if (!isEmptyHash(dto.getHash())) {
+        // a bucket the datanode no longer reports, e.g. after the number of
+        // buckets changed
+        mismatched.add(bucketId);
+      }
+      session.release(dto);
+    }
+    for (int i = 0; i < reportedHashes.length; i++) {
+      if (!seen[i] && !isEmptyHash(reportedHashes[i])) {
+        mismatched.add(i);
+      }
+    }
+
+    int[] result = new int[mismatched.size()];
+    for (int i = 0; i < result.length; i++) {
+      result[i] = mismatched.get(i);
+    }
+    Arrays.sort(result);
+    return result;
+  }
+
+  private static boolean isEmptyHash(byte[] hash) {
+    if (hash == null) {
+      return true;
+    }
+    for (byte b : hash) {
+      if (b != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   @Override
   public void prepare(Collection<HashBucket> removed,
       Collection<HashBucket> modified) throws StorageException {
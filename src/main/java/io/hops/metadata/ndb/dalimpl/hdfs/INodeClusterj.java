@@ -20,6 +20,7 @@ package io.hops.metadata.ndb.dalimpl.hdfs;
 
 import com.google.common.primitives.Longs;
 import com.mysql.clusterj.LockMode;
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.Index;
 import com.mysql.clusterj.annotation.PartitionKey;
@@ -187,6 +188,100 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
     void setNumSysXAttrs(byte numSysXAttrs);
   }
 
+  /**
+   * Column projection of hdfs_inodes holding only what {@link ProjectedINode}
+   * needs. Reads through it fetch only these columns, leaving out the
+   * client name and machine, times, generation stamp and the other columns
+   * of {@link InodeDTO}, which can not be accessed by mistake as they have no
+   * getters here. It is read only.
+   */
+  @PersistenceCapable(table = TABLE_NAME)
+  @PartitionKey(column = PARTITION_ID)
+  public interface ProjectedInodeDTO {
+    @PrimaryKey
+    @Column(name = PARTITION_ID)
+    long getPartitionId();
+    void setPartitionId(long partitionId);
+
+    @PrimaryKey
+    @Column(name = PARENT_ID)
+    long getParentId();
+    void setParentId(long parentid);
+
+    @PrimaryKey
+    @Column(name = NAME)
+    String getName();
+    void setName(String name);
+
+    @Column(name = ID)
+    long getId();
+    void setId(long id);
+
+    @Column(name = IS_DIR)
+    byte getIsDir();
+    void setIsDir(byte isDir);
+
+    @Column(name = USER_ID)
+    int getUserID();
+    void setUserID(int userID);
+
+    @Column(name = GROUP_ID)
+    int getGroupID();
+    void setGroupID(int groupID);
+
+    @Column(name = PERMISSION)
+    short getPermission();
+    void setPermission(short permission);
+
+    @Column(name = HEADER)
+    long getHeader();
+    void setHeader(long header);
+
+    @Column(name = SYMLINK)
+    String getSymlink();
+    void setSymlink(String symlink);
+
+    @Column(name = QUOTA_ENABLED)
+    byte getQuotaEnabled();
+    void setQuotaEnabled(byte quotaEnabled);
+
+    @Column(name = UNDER_CONSTRUCTION)
+    byte getUnderConstruction();
+    void setUnderConstruction(byte underConstruction);
+
+    @Column(name = SUBTREE_LOCKED)
+    byte getSubtreeLocked();
+    void setSubtreeLocked(byte locked);
+
+    @Column(name = SUBTREE_LOCK_OWNER)
+    long getSubtreeLockOwner();
+    void setSubtreeLockOwner(long leaderId);
+
+    @Column(name = SIZE)
+    long getSize();
+    void setSize(long size);
+
+    @Column(name = LOGICAL_TIME)
+    int getLogicalTime();
+    void setLogicalTime(int logicalTime);
+
+    @Column(name = STORAGE_POLICY)
+    byte getStoragePolicy();
+    void setStoragePolicy(byte storagePolicy);
+
+    @Column(name = NUM_ACES)
+    int getNumAces();
+    void setNumAces(int numAces);
+
+    @Column(name = NUM_USER_XATTRS)
+    byte getNumUserXAttrs();
+    void setNumUserXAttrs(byte numUserXAttrs);
+
+    @Column(name = NUM_SYS_XATTRS)
+    byte getNumSysXAttrs();
+    void setNumSysXAttrs(byte numSysXAttrs);
+  }
+
   private ClusterjConnector connector = ClusterjConnector.getInstance();
   private MysqlServerConnector mysqlConnector =
       MysqlServerConnector.getInstance();
@@ -198,31 +293,38 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
     HopsSession session = connector.obtainSession();
     List<InodeDTO> changes = new ArrayList<>();
     List<InodeDTO> deletions = new ArrayList<>();
+    // keys that are written again, their writes replace every column so the
+    // deletes can be dropped and deletes and writes sent in a single batch
+    Set<List<Object>> writtenKeys = new HashSet<>();
     try {
-      for (INode inode : removed) {
-        Object[] pk = new Object[3];
-        pk[0] = inode.getPartitionId();
-        pk[1] = inode.getParentId();
-        pk[2] = inode.getName();
-        InodeDTO persistable = session.newInstance(InodeDTO.class, pk);
-        deletions.add(persistable);
-      }
-
       for (INode inode : newEntries) {
         InodeDTO persistable = session.newInstance(InodeDTO.class);
         createPersistable(inode, persistable);
         changes.add(persistable);
+        writtenKeys.add(primaryKey(inode));
       }
 
       for (INode inode : modified) {
         InodeDTO persistable = session.newInstance(InodeDTO.class);
         createPersistable(inode, persistable);
         changes.add(persistable);
+        writtenKeys.add(primaryKey(inode));
+      }
+
+      for (INode inode : removed) {
+        if (writtenKeys.contains(primaryKey(inode))) {
+          continue;
+        }
+        Object[] pk = new Object[3];
+        pk[0] = inode.getPartitionId();
+        pk[1] = inode.getParentId();
+        pk[2] = inode.getName();
+        InodeDTO persistable = session.newInstance(InodeDTO.class, pk);
+        deletions.add(persistable);
       }
 
       if(!deletions.isEmpty()) {
         session.deletePersistentAll(deletions);
-        session.flush();
       }
 
       session.savePersistentAll(changes);
@@ -232,6 +334,34 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
     }
   }
 
+  /**
+   * Inserts a stream of new inodes through several concurrent sessions, see
+   * {@link BulkLoader}. Inodes are partitioned on their partition id, the
+   * distribution key of the table. Add the inodes to the returned loader and
+   * call {@link BulkLoader#finish()} once done.
+   */
+  public BulkLoader<INode> bulkInsert(int threads, int batchSize,
+      int queueDepth) {
+    return new BulkLoader<INode>("INodes", threads, batchSize, queueDepth) {
+      @Override
+      protected long partitionKey(INode inode) {
+        return inode.getPartitionId();
+      }
+
+      @Override
+      protected void write(HopsSession session, List<INode> batch)
+          throws StorageException {
+        prepare(Collections.<INode>emptyList(), batch,
+            Collections.<INode>emptyList());
+      }
+    };
+  }
+
+  private static List<Object> primaryKey(INode inode) {
+    return Arrays.<Object>asList(inode.getPartitionId(), inode.getParentId(),
+        inode.getName());
+  }
+
   @Override
   public INode findInodeByIdFTIS(long inodeId) throws StorageException {
     HopsSession session = connector.obtainSession();
@@ -341,25 +471,163 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
     }
   }
 
+  /**
+   * One batch of a directory listing, see
+   * {@link #findInodesByParentIdFTIS(long, String, int)}.
+   */
+  public static class ListingBatch<T> {
+    private final List<T> children;
+    private final String cursor;
+
+    ListingBatch(List<T> children, String cursor) {
+      this.children = children;
+      this.cursor = cursor;
+    }
+
+    public List<T> getChildren() {
+      return children;
+    }
+
+    /**
+     * @return the opaque cursor to pass to the next call, or null once the
+     * whole directory has been listed
+     */
+    public String getCursor() {
+      return cursor;
+    }
+  }
+
+  /**
+   * Lists up to limit children of parentId in name order, starting after
+   * cursor (null to start from the first child). Every batch is a bounded
+   * scan of the (parent_id, name) index that resumes after the last returned
+   * name, so large directories are listed without materializing all their
+   * children at once.
+   */
+  public ListingBatch<INode> findInodesByParentIdFTIS(long parentId,
+      String cursor, int limit) throws StorageException {
+    checkLimit(limit);
+    HopsSession session = connector.obtainSession();
+    List<InodeDTO> results = null;
+    try {
+      results = findChildrenPage(session, InodeDTO.class, parentId, null,
+          cursor, limit);
+      return new ListingBatch<>(convert(results), nextCursor(results, limit));
+    } finally {
+      session.release(results);
+    }
+  }
+
+  /**
+   * Same as {@link #findInodesByParentIdFTIS(long, String, int)} for the
+   * children stored in the partition of the parent, using the primary key.
+   */
+  public ListingBatch<INode> findInodesByParentIdAndPartitionIdPPIS(
+      long parentId, long partitionId, String cursor, int limit)
+      throws StorageException {
+    checkLimit(limit);
+    HopsSession session = connector.obtainSession();
+    List<InodeDTO> results = null;
+    try {
+      results = findChildrenPage(session, InodeDTO.class, parentId,
+          partitionId, cursor, limit);
+      return new ListingBatch<>(convert(results), nextCursor(results, limit));
+    } finally {
+      session.release(results);
+    }
+  }
+
+  /**
+   * Same as {@link #findInodesByParentIdFTIS(long, String, int)} but returns
+   * only the attributes needed to list a directory.
+   */
+  public ListingBatch<ProjectedINode> findProjectedInodesByParentIdFTIS(
+      long parentId, String cursor, int limit) throws StorageException {
+    checkLimit(limit);
+    HopsSession session = connector.obtainSession();
+    List<ProjectedInodeDTO> results = null;
+    try {
+      results = findChildrenPage(session, ProjectedInodeDTO.class, parentId,
+          null, cursor, limit);
+      List<ProjectedINode> children = new ArrayList<>(results.size());
+      for (ProjectedInodeDTO inode : results) {
+        children.add(createProjectedINode(inode));
+      }
+      return new ListingBatch<>(children, nextCursor(results, limit));
+    } finally {
+      session.release(results);
+    }
+  }
+
+  private <T> List<T> findChildrenPage(HopsSession session, Class<T> dtoClass,
+      long parentId, Long partitionId, String afterName, int limit)
+      throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<T> dobj = qb.createQueryDefinition(dtoClass);
+    HopsPredicate pred =
+        dobj.get("parentId").equal(dobj.param("parentIDParam"));
+    if (partitionId != null) {
+      pred = pred.and(
+          dobj.get("partitionId").equal(dobj.param("partitionIDParam")));
+    }
+    if (afterName != null) {
+      pred = pred.and(dobj.get("name").greaterThan(dobj.param("nameParam")));
+    }
+    dobj.where(pred);
+    HopsQuery<T> query = session.createQuery(dobj);
+    query.setParameter("parentIDParam", parentId);
+    if (partitionId != null) {
+      query.setParameter("partitionIDParam", partitionId);
+      query.setOrdering(Query.Ordering.ASCENDING, "partitionId", "parentId",
+          "name");
+    } else {
+      query.setOrdering(Query.Ordering.ASCENDING, "parentId", "name");
+    }
+    if (afterName != null) {
+      query.setParameter("nameParam", afterName);
+    }
+    query.setLimits(0, limit);
+    return query.getResultList();
+  }
+
+  private static void checkLimit(int limit) {
+    if (limit <= 0) {
+      throw new IllegalArgumentException("limit must be positive: " + limit);
+    }
+  }
+
+  /**
+   * @return the name of the last child of a full page, null if the page is
+   * the last one
+   */
+  private static String nextCursor(List<?> page, int limit) {
+    if (page.size() < limit) {
+      return null;
+    }
+    Object last = page.get(page.size() - 1);
+    return last instanceof InodeDTO ? ((InodeDTO) last).getName() :
+        ((ProjectedInodeDTO) last).getName();
+  }
+
   @Override
   public List<ProjectedINode> findInodesFTISTx(
       long parentId, EntityContext.LockMode lock) throws StorageException {
     HopsSession session = connector.obtainSession();
-    List<InodeDTO> results = null;
+    List<ProjectedInodeDTO> results = null;
     try {
       session.currentTransaction().begin();
       session.setLockMode(getLock(lock));
       HopsQueryBuilder qb = session.getQueryBuilder();
-      HopsQueryDomainType<InodeDTO> dobj =
-              qb.createQueryDefinition(InodeDTO.class);
+      HopsQueryDomainType<ProjectedInodeDTO> dobj =
+              qb.createQueryDefinition(ProjectedInodeDTO.class);
       HopsPredicate pred2 = dobj.get("parentId").equal(dobj.param("parentIDParam"));
       dobj.where(pred2);
-      HopsQuery<InodeDTO> query = session.createQuery(dobj);
+      HopsQuery<ProjectedInodeDTO> query = session.createQuery(dobj);
       query.setParameter("parentIDParam", parentId);
 
       ArrayList<ProjectedINode> resultList = new ArrayList<>();
       results = query.getResultList();
-      for (InodeDTO inode : results) {
+      for (ProjectedInodeDTO inode : results) {
         resultList.add(createProjectedINode(inode));
       }
       session.currentTransaction().commit();
@@ -372,7 +640,7 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
     }
   }
 
-  private ProjectedINode createProjectedINode(InodeDTO inode){
+  private ProjectedINode createProjectedINode(ProjectedInodeDTO inode){
     return new ProjectedINode(inode.getId(),
               inode.getParentId(),
               inode.getName(),
@@ -394,6 +662,7 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
               inode.getNumUserXAttrs(),
               inode.getNumSysXAttrs());
   }
+
 //  public List<ProjectedINode> findInodesForSubtreeOperationsWithWriteLockFTIS(
 //      int parentId) throws StorageException {
 //    final String query = String.format(
@@ -466,23 +735,23 @@ public class INodeClusterj implements TablesDef.INodeTableDef, INodeDataAccess<I
   public List<ProjectedINode> findInodesPPISTx(
           long parentId, long partitionId, EntityContext.LockMode lock) throws StorageException {
     HopsSession session = connector.obtainSession();
-    List<InodeDTO>  results = null;
+    List<ProjectedInodeDTO> results = null;
     try {
       session.currentTransaction().begin();
       session.setLockMode(getLock(lock));
       HopsQueryBuilder qb = session.getQueryBuilder();
-      HopsQueryDomainType<InodeDTO> dobj =
-              qb.createQueryDefinition(InodeDTO.class);
+      HopsQueryDomainType<ProjectedInodeDTO> dobj =
+              qb.createQueryDefinition(ProjectedInodeDTO.class);
       HopsPredicate pred1 = dobj.get("partitionId").equal(dobj.param("partitionIDParam"));
       HopsPredicate pred2 = dobj.get("parentId").equal(dobj.param("parentIDParam"));
       dobj.where(pred1.and(pred2));
-      HopsQuery<InodeDTO> query = session.createQuery(dobj);
+      HopsQuery<ProjectedInodeDTO> query = session.createQuery(dobj);
       query.setParameter("partitionIDParam", partitionId);
       query.setParameter("parentIDParam", parentId);
 
       ArrayList<ProjectedINode> resultList = new ArrayList<>();
       results = query.getResultList();
-      for (InodeDTO inode : results) {
+      for (ProjectedInodeDTO inode : results) {
         resultList.add(createProjectedINode(inode));
       }
       session.currentTransaction().commit();
@@ -36,6 +36,7 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.util.LongLongHashMap;
 import java.sql.ResultSet;
 import java.sql.SQLException;
 
@@ -133,6 +134,27 @@ public class InvalidatedBlockClusterj implements
     });
   }
 
+  /**
+   * Bulk variant of {@link #findInvalidatedBlockBySidUsingMySQLServer(int)}
+   * that streams the (blockId, generationStamp) pairs into a primitive map.
+   */
+  public LongLongHashMap findInvalidatedBlockBySidUsingMySQLServerBulk(
+      int storageId) throws StorageException {
+    return MySQLQueryHelper.executeStreaming(String.format("SELECT %s, %s "
+            + "FROM %s WHERE %s=%d", BLOCK_ID, GENERATION_STAMP, TABLE_NAME,
+        STORAGE_ID, storageId),
+        new MySQLQueryHelper.ResultSetHandler<LongLongHashMap>() {
+          @Override
+          public LongLongHashMap handle(ResultSet result) throws SQLException {
+            LongLongHashMap blockGenStampMap = new LongLongHashMap();
+            while (result.next()) {
+              blockGenStampMap.put(result.getLong(1), result.getLong(2));
+            }
+            return blockGenStampMap;
+          }
+        });
+  }
+
   @Override
   public List<InvalidatedBlock> findInvalidatedBlocksByBlockId(long bid,
       long inodeId) throws StorageException {
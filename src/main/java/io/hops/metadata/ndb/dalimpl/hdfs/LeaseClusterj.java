@@ -18,6 +18,7 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.Index;
 import com.mysql.clusterj.annotation.PartitionKey;
@@ -152,6 +153,73 @@ public class LeaseClusterj implements TablesDef.LeaseTableDef, LeaseDataAccess<L
     return ll;
   }
 
+  /**
+   * Incremental version of {@link #findByTimeLimit(long)} for the lease
+   * monitor. Returns up to limit leases with lastUpdate < timeLimit, oldest
+   * first, that come after the lease (afterLastUpdate, afterHolderId) in
+   * (last_update, holder_id) order. Pass Long.MIN_VALUE as afterLastUpdate to
+   * start from the oldest lease and the last returned lease as the checkpoint
+   * of the next call. Every call is a bounded scan of the update_idx index,
+   * so a pass only reads the leases it returns.
+   */
+  public List<Lease> findByTimeLimitAfter(long timeLimit, long afterLastUpdate,
+      int afterHolderId, int limit) throws StorageException {
+    HopsSession session = connector.obtainSession();
+    List<Lease> leases = new ArrayList<>(limit);
+    if (afterLastUpdate != Long.MIN_VALUE && afterLastUpdate < timeLimit) {
+      // leases renewed in the same millisecond as the checkpoint
+      List<LeaseDTO> ties = findByLastUpdate(session, afterLastUpdate,
+          afterHolderId, limit);
+      try {
+        leases.addAll(createList(ties));
+      } finally {
+        session.release(ties);
+      }
+    }
+    if (leases.size() < limit) {
+      List<LeaseDTO> dtos = findByLastUpdateRange(session, afterLastUpdate,
+          timeLimit, limit - leases.size());
+      try {
+        leases.addAll(createList(dtos));
+      } finally {
+        session.release(dtos);
+      }
+    }
+    return leases;
+  }
+
+  private List<LeaseDTO> findByLastUpdate(HopsSession session,
+      long lastUpdate, int afterHolderId, int limit) throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<LeaseDTO> dobj =
+        qb.createQueryDefinition(LeaseDTO.class);
+    HopsPredicate pred = dobj.get("lastUpdate").equal(dobj.param("lastUpdate"))
+        .and(dobj.get("holderId").greaterThan(dobj.param("holderId")));
+    dobj.where(pred);
+    HopsQuery<LeaseDTO> query = session.createQuery(dobj);
+    query.setParameter("lastUpdate", lastUpdate);
+    query.setParameter("holderId", afterHolderId);
+    query.setOrdering(Query.Ordering.ASCENDING, "lastUpdate", "holderId");
+    query.setLimits(0, limit);
+    return query.getResultList();
+  }
+
+  private List<LeaseDTO> findByLastUpdateRange(HopsSession session,
+      long afterLastUpdate, long timeLimit, int limit) throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<LeaseDTO> dobj =
+        qb.createQueryDefinition(LeaseDTO.class);
+    HopsPredicate pred = dobj.get("lastUpdate").greaterThan(dobj.param("from"))
+        .and(dobj.get("lastUpdate").lessThan(dobj.param("to")));
+    dobj.where(pred);
+    HopsQuery<LeaseDTO> query = session.createQuery(dobj);
+    query.setParameter("from", afterLastUpdate);
+    query.setParameter("to", timeLimit);
+    query.setOrdering(Query.Ordering.ASCENDING, "lastUpdate", "holderId");
+    query.setLimits(0, limit);
+    return query.getResultList();
+  }
+
   @Override
   public void prepare(Collection<Lease> removed, Collection<Lease> newed,
       Collection<Lease> modified) throws StorageException {
@@ -18,6 +18,8 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.LockMode;
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.Index;
 import com.mysql.clusterj.annotation.PartitionKey;
@@ -65,6 +67,9 @@ public class LeasePathClusterj
     void setPenultimateBlockId(long penultimateBlockId);
   }
 
+  private static final int PREFIX_SCAN_PAGE_SIZE = 1000;
+  private static final long NOT_FOUND_ROW = Long.MIN_VALUE;
+
   private ClusterjConnector connector = ClusterjConnector.getInstance();
 
   @Override
@@ -147,24 +152,123 @@ public class LeasePathClusterj
     }
   }
 
+  /**
+   * Walks the path_idx index in order from the prefix, one bounded page at a
+   * time, and stops at the first path that does not start with the prefix.
+   * Paths sharing a prefix are contiguous in the index. An upper bound such as
+   * prefix + 0xFF is not used because 0xFF does not sort last in
+   * latin1_general_cs.
+   * <p/>
+   * The walk reads without locks, as its last page may go past the matching
+   * paths. The matching rows are then read again by primary key in the lock
+   * mode of the caller, so only they are locked.
+   */
   @Override
   public Collection<LeasePath> findByPrefix(String prefix)
       throws StorageException {
     HopsSession dbSession = connector.obtainSession();
+    LockMode lockMode = dbSession.getCurrentLockMode();
+    List<LeasePath> lpl = new ArrayList<>();
+    dbSession.setLockMode(LockMode.READ_COMMITTED);
+    try {
+      String from = prefix;
+      boolean inclusive = true;
+      boolean done = false;
+      while (!done) {
+        List<LeasePathsDTO> dtos =
+            findPathsPage(dbSession, from, inclusive, PREFIX_SCAN_PAGE_SIZE);
+        try {
+          done = dtos.size() < PREFIX_SCAN_PAGE_SIZE;
+          // the holders of the last path may go on past the end of the page,
+          // they are all read by the next query
+          String last = done ? null : dtos.get(dtos.size() - 1).getPath();
+          for (LeasePathsDTO dto : dtos) {
+            if (!dto.getPath().startsWith(prefix)) {
+              done = true;
+              break;
+            }
+            if (!dto.getPath().equals(last)) {
+              lpl.add(createLeasePath(dto));
+            }
+          }
+          if (!done) {
+            lpl.addAll(findAllByPath(dbSession, last));
+            from = last;
+            inclusive = false;
+          }
+        } finally {
+          dbSession.release(dtos);
+        }
+      }
+    } finally {
+      dbSession.setLockMode(lockMode);
+    }
+    if (lockMode == LockMode.READ_COMMITTED || lpl.isEmpty()) {
+      return lpl;
+    }
+    return lock(dbSession, lpl);
+  }
+
+  /**
+   * Reads the given lease paths by primary key in the current lock mode.
+   *
+   * @return the ones that still exist
+   */
+  private List<LeasePath> lock(HopsSession dbSession, List<LeasePath> lpl)
+      throws StorageException {
+    List<LeasePathsDTO> dtos = new ArrayList<>(lpl.size());
+    try {
+      for (LeasePath lp : lpl) {
+        LeasePathsDTO dto = dbSession.newInstance(LeasePathsDTO.class,
+            new Object[]{lp.getHolderId(), lp.getPath()});
+        dto.setLastBlockId(NOT_FOUND_ROW);
+        dbSession.load(dto);
+        dtos.add(dto);
+      }
+      dbSession.flush();
+      List<LeasePath> locked = new ArrayList<>(dtos.size());
+      for (LeasePathsDTO dto : dtos) {
+        if (dto.getLastBlockId() != NOT_FOUND_ROW) {
+          locked.add(createLeasePath(dto));
+        }
+      }
+      return locked;
+    } finally {
+      dbSession.release(dtos);
+    }
+  }
+
+  private List<LeasePath> findAllByPath(HopsSession dbSession, String path)
+      throws StorageException {
     HopsQueryBuilder qb = dbSession.getQueryBuilder();
-    HopsQueryDomainType dobj = qb.createQueryDefinition(LeasePathsDTO.class);
-    HopsPredicateOperand propertyPredicate = dobj.get("path");
-    String param = "prefix";
-    HopsPredicateOperand propertyLimit = dobj.param(param);
-    HopsPredicate like = propertyPredicate.like(propertyLimit);
-    dobj.where(like);
-    HopsQuery query = dbSession.createQuery(dobj);
-    query.setParameter(param, prefix + "%");
-    
-    Collection<LeasePathsDTO> dtos = query.getResultList();
-    Collection<LeasePath> lpl = createList(dtos);
-    dbSession.release(dtos);
-    return lpl;
+    HopsQueryDomainType<LeasePathsDTO> dobj =
+        qb.createQueryDefinition(LeasePathsDTO.class);
+    dobj.where(dobj.get("path").equal(dobj.param("path")));
+    HopsQuery<LeasePathsDTO> query = dbSession.createQuery(dobj);
+    query.setParameter("path", path);
+    List<LeasePathsDTO> dtos = query.getResultList();
+    try {
+      return createList(dtos);
+    } finally {
+      dbSession.release(dtos);
+    }
+  }
+
+  private List<LeasePathsDTO> findPathsPage(HopsSession dbSession,
+      String from, boolean inclusive, int limit) throws StorageException {
+    HopsQueryBuilder qb = dbSession.getQueryBuilder();
+    HopsQueryDomainType<LeasePathsDTO> dobj =
+        qb.createQueryDefinition(LeasePathsDTO.class);
+    HopsPredicateOperand path = dobj.get("path");
+    HopsPredicate pred = inclusive ?
+        path.greaterEqual(dobj.param("from")) :
+        path.greaterThan(dobj.param("from"));
+    dobj.where(pred);
+    HopsQuery<LeasePathsDTO> query = dbSession.createQuery(dobj);
+    query.setParameter("from", from);
+    query.setOrdering(Query.Ordering.ASCENDING, "path");
+    query.setLimits(0, limit);
+    return query.getResultList();
   }
 
   @Override
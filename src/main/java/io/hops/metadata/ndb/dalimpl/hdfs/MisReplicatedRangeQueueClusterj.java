@@ -18,6 +18,7 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.LockMode;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
@@ -51,11 +52,196 @@ public class MisReplicatedRangeQueueClusterj
     long getStartIndex();
 
     void setStartIndex(long startIndex);
+
+    @Column(name = OWNER_ID)
+    long getOwnerId();
+
+    void setOwnerId(long ownerId);
+
+    @Column(name = LEASE_EXPIRY)
+    long getLeaseExpiry();
+
+    void setLeaseExpiry(long leaseExpiry);
   }
 
+  static final String OWNER_ID = "owner_id";
+  static final String LEASE_EXPIRY = "lease_expiry";
+  public static final long NO_OWNER = -1;
+
   private ClusterjConnector connector = ClusterjConnector.getInstance();
   private final static String SEPERATOR = "-";
 
+  /**
+   * Claims up to max ranges that are not leased or whose lease expired, for
+   * leaseTime ms. Several namenodes can claim concurrently: the candidate
+   * rows are read with an exclusive lock and their lease is checked again
+   * before it is taken over, so a range is given to one namenode at a time.
+   * Runs in its own transaction.
+   *
+   * @return the claimed ranges, empty if there is nothing left to claim
+   */
+  public List<MisReplicatedRange> claim(final long ownerId, final int max,
+      final long leaseTime) throws StorageException {
+    return inOwnTransaction(new LeaseOperation<List<MisReplicatedRange>>() {
+      @Override
+      public List<MisReplicatedRange> run(HopsSession session)
+          throws StorageException {
+        long now = System.currentTimeMillis();
+        HopsQueryBuilder qb = session.getQueryBuilder();
+        HopsQueryDomainType<MisReplicatedRangeQueueDTO> dobj =
+            qb.createQueryDefinition(MisReplicatedRangeQueueDTO.class);
+        dobj.where(dobj.get("leaseExpiry").lessThan(dobj.param("now")));
+        HopsQuery<MisReplicatedRangeQueueDTO> query =
+            session.createQuery(dobj);
+        query.setParameter("now", now);
+        query.setLimits(0, max);
+        List<MisReplicatedRangeQueueDTO> dtos = query.getResultList();
+        List<MisReplicatedRangeQueueDTO> claimed = new ArrayList<>();
+        try {
+          for (MisReplicatedRangeQueueDTO dto : dtos) {
+            if (dto.getLeaseExpiry() < now) {
+              dto.setOwnerId(ownerId);
+              dto.setLeaseExpiry(now + leaseTime);
+              claimed.add(dto);
+            }
+          }
+          session.updatePersistentAll(claimed);
+          return convert(claimed);
+        } finally {
+          session.release(dtos);
+        }
+      }
+    });
+  }
+
+  /**
+   * Extends the lease of a range held by ownerId.
+   *
+   * @return false if the range is gone or was claimed by someone else after
+   * its lease expired
+   */
+  public boolean renew(final long ownerId, final MisReplicatedRange range,
+      final long leaseTime) throws StorageException {
+    return inOwnTransaction(new LeaseOperation<Boolean>() {
+      @Override
+      public Boolean run(HopsSession session) throws StorageException {
+        MisReplicatedRangeQueueDTO dto =
+            session.find(MisReplicatedRangeQueueDTO.class, range.getNnId());
+        try {
+          if (!isHeldBy(dto, ownerId, range)) {
+            return false;
+          }
+          dto.setLeaseExpiry(System.currentTimeMillis() + leaseTime);
+          session.updatePersistent(dto);
+          return true;
+        } finally {
+          session.release(dto);
+        }
+      }
+    });
+  }
+
+  /**
+   * Removes the processed ranges that are still held by ownerId. Ranges
+   * that were re-claimed by another namenode are left to it.
+   *
+   * @return the number of ranges removed
+   */
+  public int complete(final long ownerId, final List<MisReplicatedRange> ranges)
+      throws StorageException {
+    return inOwnTransaction(new LeaseOperation<Integer>() {
+      @Override
+      public Integer run(HopsSession session) throws StorageException {
+        List<MisReplicatedRangeQueueDTO> dtos = new ArrayList<>(ranges.size());
+        List<MisReplicatedRangeQueueDTO> held = new ArrayList<>();
+        try {
+          for (MisReplicatedRange range : ranges) {
+            MisReplicatedRangeQueueDTO dto = session.newInstance(
+                MisReplicatedRangeQueueDTO.class, range.getNnId());
+            dto.setOwnerId(NO_OWNER);
+            session.load(dto);
+            dtos.add(dto);
+          }
+          session.flush();
+          for (int i = 0; i < dtos.size(); i++) {
+            if (isHeldBy(dtos.get(i), ownerId, ranges.get(i))) {
+              held.add(dtos.get(i));
+            }
+          }
+          session.deletePersistentAll(held);
+          return held.size();
+        } finally {
+          session.release(dtos);
+        }
+      }
+    });
+  }
+
+  /**
+   * Gives the ranges held by ownerId back to the queue without processing
+   * them, so that any namenode can claim them right away.
+   */
+  public void release(final long ownerId, final List<MisReplicatedRange> ranges)
+      throws StorageException {
+    inOwnTransaction(new LeaseOperation<Void>() {
+      @Override
+      public Void run(HopsSession session) throws StorageException {
+        List<MisReplicatedRangeQueueDTO> released = new ArrayList<>();
+        try {
+          for (MisReplicatedRange range : ranges) {
+            MisReplicatedRangeQueueDTO dto = session.find(
+                MisReplicatedRangeQueueDTO.class, range.getNnId());
+            if (isHeldBy(dto, ownerId, range)) {
+              dto.setOwnerId(NO_OWNER);
+              dto.setLeaseExpiry(0);
+              released.add(dto);
+            } else {
+              session.release(dto);
+            }
+          }
+          session.updatePersistentAll(released);
+          return null;
+        } finally {
+          session.release(released);
+        }
+      }
+    });
+  }
+
+  private static boolean isHeldBy(MisReplicatedRangeQueueDTO dto,
+      long ownerId, MisReplicatedRange range) {
+    return dto != null && dto.getOwnerId() == ownerId &&
+        dto.getStartIndex() == range.getStartIndex();
+  }
+
+  private interface LeaseOperation<R> {
+    R run(HopsSession session) throws StorageException;
+  }
+
+  private <R> R inOwnTransaction(LeaseOperation<R> operation)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    if (session.currentTransaction().isActive()) {
+      throw new StorageException("Mis-replicated range leases must be " +
+          "taken outside of a transaction");
+    }
+    LockMode lockMode = session.getCurrentLockMode();
+    try {
+      session.currentTransaction().begin();
+      session.setLockMode(LockMode.EXCLUSIVE);
+      R result = operation.run(session);
+      session.currentTransaction().commit();
+      return result;
+    } catch (StorageException e) {
+      if (session.currentTransaction().isActive()) {
+        session.currentTransaction().rollback();
+      }
+      throw e;
+    } finally {
+      session.setLockMode(lockMode);
+    }
+  }
+
   @Override
   public void insert(MisReplicatedRange range) throws StorageException {
     HopsSession session = connector.obtainSession();
@@ -124,6 +310,8 @@ public class MisReplicatedRangeQueueClusterj
     MisReplicatedRangeQueueDTO dto = session.newInstance(MisReplicatedRangeQueueDTO.class);
     dto.setNnId(range.getNnId());
     dto.setStartIndex(range.getStartIndex());
+    dto.setOwnerId(NO_OWNER);
+    dto.setLeaseExpiry(0);
     return dto;
   }
   
@@ -0,0 +1,530 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.dalimpl.hdfs;
+
+import com.mysql.clusterj.Query;
+import io.hops.exception.StorageException;
+import io.hops.metadata.hdfs.TablesDef;
+import io.hops.metadata.hdfs.entity.BlockInfo;
+import io.hops.metadata.hdfs.entity.INode;
+import io.hops.metadata.hdfs.entity.Replica;
+import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.NdbBoolean;
+import io.hops.metadata.ndb.NdbStorageFactory;
+import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
+import io.hops.metadata.ndb.wrapper.HopsQuery;
+import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
+import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
+import io.hops.metadata.ndb.wrapper.HopsSession;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
+import java.io.DataInput;
+import java.io.DataInputStream;
+import java.io.DataOutput;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.FilenameFilter;
+import java.io.IOException;
+import java.io.InputStream;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Properties;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+
+/**
+ * Command line tool that exports hdfs_inodes, hdfs_block_infos and
+ * hdfs_replicas to a directory of compact binary files, or imports them
+ * back, without going through the namenode.
+ * <p/>
+ * The export splits the inode id space of each table in one range per
+ * thread. Every range is read with its own session in keyset pages of an
+ * ordered index (inode_idx for inodes, the primary key for blocks and
+ * replicas) and written to its own file, so a table is exported as one file
+ * per thread. The import reads the files of each table in turn and writes
+ * the rows through a {@link BulkLoader}, in batched transactions partitioned
+ * on the distribution key of the table. Blocks are imported together with
+ * their hdfs_block_lookup_table rows.
+ * <p/>
+ * The import expects empty tables and does not move the id counters in
+ * hdfs_variables, which have to be set past the imported ids before a
+ * namenode is started.
+ * <p/>
+ * Usage: NamespaceBulkTool export|import ndb-config.properties dir [threads]
+ */
+public class NamespaceBulkTool {
+  static final Log LOG = LogFactory.getLog(NamespaceBulkTool.class);
+
+  private static final int MAGIC = 0x484e5342;
+  private static final int FORMAT_VERSION = 1;
+  private static final int PAGE_SIZE = 10000;
+  private static final int BATCH_SIZE = 1000;
+  private static final int QUEUE_DEPTH = 4;
+  private static final String FILE_SUFFIX = ".bin";
+
+  /**
+   * How the rows of one table are read, encoded and written back.
+   *
+   * @param <D>
+   *     the DTO the table is read with
+   * @param <E>
+   *     the entity the table is written with
+   */
+  private abstract static class Table<D, E> {
+    private final String name;
+    private final String tableName;
+    private final String keyColumn;
+    private final String keyField;
+    private final Class<D> dtoClass;
+
+    Table(String name, String tableName, String keyColumn, String keyField,
+        Class<D> dtoClass) {
+      this.name = name;
+      this.tableName = tableName;
+      this.keyColumn = keyColumn;
+      this.keyField = keyField;
+      this.dtoClass = dtoClass;
+    }
+
+    /**
+     * @return the value of the ordered index column the export ranges and
+     * pages are built on
+     */
+    abstract long key(D dto);
+
+    abstract void write(DataOutput out, D dto) throws IOException;
+
+    abstract E read(DataInput in) throws IOException;
+
+    abstract BulkLoader<E> loader(int threads);
+  }
+
+  private static final Table<INodeClusterj.InodeDTO, INode> INODES =
+      new Table<INodeClusterj.InodeDTO, INode>("inodes",
+          TablesDef.INodeTableDef.TABLE_NAME, TablesDef.INodeTableDef.ID,
+          "id", INodeClusterj.InodeDTO.class) {
+        @Override
+        long key(INodeClusterj.InodeDTO dto) {
+          return dto.getId();
+        }
+
+        @Override
+        void write(DataOutput out, INodeClusterj.InodeDTO dto)
+            throws IOException {
+          out.writeLong(dto.getId());
+          out.writeUTF(dto.getName());
+          out.writeLong(dto.getParentId());
+          out.writeLong(dto.getPartitionId());
+          out.writeByte(dto.getIsDir());
+          out.writeByte(dto.getQuotaEnabled());
+          out.writeLong(dto.getModificationTime());
+          out.writeLong(dto.getATime());
+          out.writeInt(dto.getUserID());
+          out.writeInt(dto.getGroupID());
+          out.writeShort(dto.getPermission());
+          out.writeByte(dto.getUnderConstruction());
+          writeString(out, dto.getClientName());
+          writeString(out, dto.getClientMachine());
+          out.writeInt(dto.getGenerationStamp());
+          out.writeLong(dto.getHeader());
+          writeString(out, dto.getSymlink());
+          out.writeByte(dto.getSubtreeLocked());
+          out.writeLong(dto.getSubtreeLockOwner());
+          out.writeByte(dto.getMetaEnabled());
+          out.writeLong(dto.getSize());
+          out.writeByte(dto.getFileStoredInDd());
+          out.writeInt(dto.getLogicalTime());
+          out.writeByte(dto.getStoragePolicy());
+          out.writeInt(dto.getChildrenNum());
+          out.writeInt(dto.getNumAces());
+          out.writeByte(dto.getNumUserXAttrs());
+          out.writeByte(dto.getNumSysXAttrs());
+        }
+
+        @Override
+        INode read(DataInput in) throws IOException {
+          // same fields, in the same order, as INodeClusterj.convert
+          return new INode(in.readLong(), in.readUTF(), in.readLong(),
+              in.readLong(), NdbBoolean.convert(in.readByte()),
+              NdbBoolean.convert(in.readByte()), in.readLong(), in.readLong(),
+              in.readInt(), in.readInt(), in.readShort(),
+              NdbBoolean.convert(in.readByte()), readString(in),
+              readString(in), in.readInt(), in.readLong(), readString(in),
+              NdbBoolean.convert(in.readByte()), in.readLong(), in.readByte(),
+              in.readLong(), NdbBoolean.convert(in.readByte()), in.readInt(),
+              in.readByte(), in.readInt(), in.readInt(), in.readByte(),
+              in.readByte());
+        }
+
+        @Override
+        BulkLoader<INode> loader(int threads) {
+          return new INodeClusterj().bulkInsert(threads, BATCH_SIZE,
+              QUEUE_DEPTH);
+        }
+      };
+
+  private static final Table<BlockInfoClusterj.BlockInfoDTO, BlockInfo>
+      BLOCKS = new Table<BlockInfoClusterj.BlockInfoDTO, BlockInfo>(
+          "blocks", TablesDef.BlockInfoTableDef.TABLE_NAME,
+          TablesDef.BlockInfoTableDef.INODE_ID, "iNodeId",
+          BlockInfoClusterj.BlockInfoDTO.class) {
+        @Override
+        long key(BlockInfoClusterj.BlockInfoDTO dto) {
+          return dto.getINodeId();
+        }
+
+        @Override
+        void write(DataOutput out, BlockInfoClusterj.BlockInfoDTO dto)
+            throws IOException {
+          out.writeLong(dto.getBlockId());
+          out.writeInt(dto.getBlockIndex());
+          out.writeLong(dto.getINodeId());
+          out.writeLong(dto.getNumBytes());
+          out.writeLong(dto.getGenerationStamp());
+          out.writeInt(dto.getBlockUCState());
+          out.writeLong(dto.getTimestamp());
+          out.writeInt(dto.getPrimaryNodeIndex());
+          out.writeLong(dto.getBlockRecoveryId());
+          out.writeLong(dto.getTruncateBlockNumBytes());
+          out.writeLong(dto.getTruncateBlockGenerationBlock());
+        }
+
+        @Override
+        BlockInfo read(DataInput in) throws IOException {
+          return new BlockInfo(in.readLong(), in.readInt(), in.readLong(),
+              in.readLong(), in.readLong(), in.readInt(), in.readLong(),
+              in.readInt(), in.readLong(), in.readLong(), in.readLong());
+        }
+
+        @Override
+        BulkLoader<BlockInfo> loader(int threads) {
+          return new BlockInfoClusterj().bulkInsert(threads, BATCH_SIZE,
+              QUEUE_DEPTH);
+        }
+      };
+
+  private static final Table<ReplicaClusterj.ReplicaDTO, Replica> REPLICAS =
+      new Table<ReplicaClusterj.ReplicaDTO, Replica>("replicas",
+          TablesDef.ReplicaTableDef.TABLE_NAME,
+          TablesDef.ReplicaTableDef.INODE_ID, "iNodeId",
+          ReplicaClusterj.ReplicaDTO.class) {
+        @Override
+        long key(ReplicaClusterj.ReplicaDTO dto) {
+          return dto.getINodeId();
+        }
+
+        @Override
+        void write(DataOutput out, ReplicaClusterj.ReplicaDTO dto)
+            throws IOException {
+          out.writeInt(dto.getStorageId());
+          out.writeLong(dto.getBlockId());
+          out.writeLong(dto.getINodeId());
+          out.writeInt(dto.getBucketId());
+        }
+
+        @Override
+        Replica read(DataInput in) throws IOException {
+          return new Replica(in.readInt(), in.readLong(), in.readLong(),
+              in.readInt());
+        }
+
+        @Override
+        BulkLoader<Replica> loader(int threads) {
+          return new ReplicaClusterj().bulkInsert(threads, BATCH_SIZE,
+              QUEUE_DEPTH);
+        }
+      };
+
+  private static final List<Table<?, ?>> TABLES =
+      Arrays.<Table<?, ?>>asList(INODES, BLOCKS, REPLICAS);
+
+  private final File dir;
+  private final int threads;
+
+  public NamespaceBulkTool(File dir, int threads) {
+    if (threads <= 0) {
+      throw new IllegalArgumentException("threads must be positive: " +
+          threads);
+    }
+    this.dir = dir;
+    this.threads = threads;
+  }
+
+  public static void main(String[] args) {
+    if (args.length < 3 || !(args[0].equals("export") ||
+        args[0].equals("import"))) {
+      System.err.println("Usage: NamespaceBulkTool export|import " +
+          "ndb-config.properties dir [threads]");
+      System.exit(2);
+    }
+    // the ClusterJ connection threads would keep the JVM alive, so exit
+    // explicitly whether the tool succeeds or fails
+    int status = 0;
+    try {
+      Properties conf = new Properties();
+      InputStream confIn = new FileInputStream(args[1]);
+      try {
+        conf.load(confIn);
+      } finally {
+        confIn.close();
+      }
+      new NdbStorageFactory().setConfiguration(conf);
+
+      int threads = args.length > 3 ? Integer.parseInt(args[3]) :
+          Runtime.getRuntime().availableProcessors();
+      NamespaceBulkTool tool =
+          new NamespaceBulkTool(new File(args[2]), threads);
+      if (args[0].equals("export")) {
+        tool.exportAll();
+      } else {
+        tool.importAll();
+      }
+    } catch (Throwable t) {
+      LOG.error("Namespace " + args[0] + " failed", t);
+      status = 1;
+    }
+    System.exit(status);
+  }
+
+  /**
+   * Exports the three tables, one file per table and thread.
+   *
+   * @return the number of rows exported
+   */
+  public long exportAll() throws StorageException, IOException {
+    if (!dir.isDirectory() && !dir.mkdirs()) {
+      throw new IOException("Could not create " + dir);
+    }
+    ExecutorService executor = Executors.newFixedThreadPool(threads);
+    try {
+      List<Future<Long>> exports = new ArrayList<>();
+      for (Table<?, ?> table : TABLES) {
+        long min = MySQLQueryHelper.minLong(table.tableName, table.keyColumn);
+        long max = MySQLQueryHelper.maxLong(table.tableName, table.keyColumn);
+        long rangeSize = Math.max(1, (max - min) / threads + 1);
+        for (int i = 0; i < threads; i++) {
+          long lo = min + i * rangeSize;
+          long hi = i == threads - 1 ? max : lo + rangeSize - 1;
+          exports.add(executor.submit(
+              exportRange(table, lo, hi, file(table, i))));
+        }
+      }
+      long rows = 0;
+      for (Future<Long> export : exports) {
+        rows += get(export);
+      }
+      LOG.info("Exported " + rows + " rows to " + dir);
+      return rows;
+    } finally {
+      executor.shutdownNow();
+    }
+  }
+
+  /**
+   * Imports the files of the three tables, inodes first.
+   *
+   * @return the number of rows imported
+   */
+  public long importAll() throws StorageException, IOException {
+    long rows = 0;
+    for (Table<?, ?> table : TABLES) {
+      rows += importTable(table);
+    }
+    LOG.info("Imported " + rows + " rows from " + dir);
+    return rows;
+  }
+
+  private <D, E> Callable<Long> exportRange(final Table<D, E> table,
+      final long lo, final long hi, final File file) {
+    return new Callable<Long>() {
+      @Override
+      public Long call() throws StorageException, IOException {
+        ClusterjConnector connector = ClusterjConnector.getInstance();
+        boolean error = false;
+        DataOutputStream out = new DataOutputStream(
+            new BufferedOutputStream(new FileOutputStream(file), 1 << 20));
+        try {
+          out.writeInt(MAGIC);
+          out.writeInt(FORMAT_VERSION);
+          HopsSession session = connector.obtainSession();
+          long rows = 0;
+          long after = lo - 1;
+          while (after < hi) {
+            List<D> page = readPage(session, table, after, hi, PAGE_SIZE);
+            long lastKey;
+            try {
+              if (page.size() < PAGE_SIZE) {
+                rows += write(out, table, page, null);
+                break;
+              }
+              lastKey = table.key(page.get(page.size() - 1));
+              rows += write(out, table, page, lastKey);
+            } finally {
+              session.release(page);
+            }
+            // the rows of the last key may go on past the end of the page
+            List<D> rest = readPage(session, table, lastKey - 1, lastKey, 0);
+            try {
+              rows += write(out, table, rest, null);
+            } finally {
+              session.release(rest);
+            }
+            after = lastKey;
+          }
+          out.writeBoolean(false);
+          LOG.debug("Exported " + rows + " rows of " + table.tableName +
+              " in [" + lo + ", " + hi + "] to " + file);
+          return rows;
+        } catch (StorageException | IOException e) {
+          error = true;
+          throw e;
+        } finally {
+          out.close();
+          connector.returnSession(error);
+        }
+      }
+    };
+  }
+
+  /**
+   * Reads the rows whose key is in (after, hi], ordered on the key.
+   *
+   * @param limit
+   *     max number of rows, 0 for no limit
+   */
+  private static <D> List<D> readPage(HopsSession session, Table<D, ?> table,
+      long after, long hi, int limit) throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<D> dobj = qb.createQueryDefinition(table.dtoClass);
+    dobj.where(dobj.get(table.keyField).greaterThan(dobj.param("after"))
+        .and(dobj.get(table.keyField).lessEqual(dobj.param("hi"))));
+    HopsQuery<D> query = session.createQuery(dobj);
+    query.setParameter("after", after);
+    query.setParameter("hi", hi);
+    query.setOrdering(Query.Ordering.ASCENDING, table.keyField);
+    if (limit > 0) {
+      query.setLimits(0, limit);
+    }
+    return query.getResultList();
+  }
+
+  /**
+   * Writes the rows, except the ones of skipKey if it is not null.
+   */
+  private static <D> long write(DataOutput out, Table<D, ?> table,
+      List<D> rows, Long skipKey) throws IOException {
+    long written = 0;
+    for (D dto : rows) {
+      if (skipKey != null && table.key(dto) == skipKey) {
+        continue;
+      }
+      out.writeBoolean(true);
+      table.write(out, dto);
+      written++;
+    }
+    return written;
+  }
+
+  private <D, E> long importTable(final Table<D, E> table)
+      throws StorageException, IOException {
+    File[] files = dir.listFiles(new FilenameFilter() {
+      @Override
+      public boolean accept(File d, String name) {
+        return name.startsWith(table.name + "-") &&
+            name.endsWith(FILE_SUFFIX);
+      }
+    });
+    if (files == null) {
+      throw new IOException("Could not list " + dir);
+    }
+    Arrays.sort(files);
+    BulkLoader<E> loader = table.loader(threads);
+    boolean read = false;
+    try {
+      for (File file : files) {
+        DataInputStream in = new DataInputStream(
+            new BufferedInputStream(new FileInputStream(file), 1 << 20));
+        try {
+          if (in.readInt() != MAGIC || in.readInt() != FORMAT_VERSION) {
+            throw new IOException(file + " is not a namespace export of " +
+                "version " + FORMAT_VERSION);
+          }
+          while (in.readBoolean()) {
+            loader.add(table.read(in));
+          }
+        } finally {
+          in.close();
+        }
+      }
+      read = true;
+    } finally {
+      if (!read) {
+        loader.abort();
+      }
+    }
+    long rows = loader.finish();
+    LOG.info("Imported " + rows + " rows into " + table.tableName + " at " +
+        (long) loader.getRowsPerSecond() + " rows/s");
+    return rows;
+  }
+
+  private File file(Table<?, ?> table, int index) {
+    return new File(dir, String.format("%s-%04d%s", table.name, index,
+        FILE_SUFFIX));
+  }
+
+  private static long get(Future<Long> future)
+      throws StorageException, IOException {
+    try {
+      return future.get();
+    } catch (ExecutionException e) {
+      if (e.getCause() instanceof StorageException) {
+        throw (StorageException) e.getCause();
+      }
+      if (e.getCause() instanceof IOException) {
+        throw (IOException) e.getCause();
+      }
+      throw new StorageException(e.getCause());
+    } catch (InterruptedException e) {
+      Thread.currentThread().interrupt();
+      throw new StorageException(e);
+    }
+  }
+
+  private static void writeString(DataOutput out, String s)
+      throws IOException {
+    out.writeBoolean(s != null);
+    if (s != null) {
+      out.writeUTF(s);
+    }
+  }
+
+  private static String readString(DataInput in) throws IOException {
+    return in.readBoolean() ? in.readUTF() : null;
+  }
+}
@@ -18,6 +18,7 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.PartitionKey;
 import com.mysql.clusterj.annotation.PersistenceCapable;
@@ -80,6 +81,8 @@ public class OnGoingSubTreeOpsClusterj
     void setInodeId(long inodeId);
   }
 
+  private static final int NOT_FOUND_ROW = -1;
+
   private ClusterjConnector connector = ClusterjConnector.getInstance();
 
   @Override
@@ -198,6 +201,83 @@ public class OnGoingSubTreeOpsClusterj
     return convertAndRelease(dbSession, query.getResultList());
   }
 
+  /**
+   * Returns an active subtree operation overlapping path, that is an
+   * operation on path itself, on one of its ancestors or on one of its
+   * descendants, or null if there is none. All of them live in the partition
+   * of the first path component, so the check costs one batch of primary key
+   * reads, one per path component, and one ordered primary key scan that
+   * reads at most one row, instead of a scan of the whole table.
+   * <p/>
+   * The path is normalised once, without empty components and without a
+   * trailing separator, and that form is used for both the primary key reads
+   * and the descendant scan. The root can not be locked.
+   */
+  public SubTreeOperation findOverlappingOp(String path)
+      throws StorageException {
+    List<String> ancestors = new ArrayList<>();
+    StringBuilder ancestor = new StringBuilder();
+    for (String component : PathUtils.getPathNames(path)) {
+      if (component.isEmpty()) {
+        continue;
+      }
+      ancestor.append(PathUtils.SEPARATOR).append(component);
+      ancestors.add(ancestor.toString());
+    }
+    if (ancestors.isEmpty()) {
+      throw new UnsupportedOperationException(
+          "Taking sub tree lock on the root is not yet supported ");
+    }
+    String normalised = ancestors.get(ancestors.size() - 1);
+    int partitionId = getHash(normalised);
+    HopsSession session = connector.obtainSession();
+
+    // the ancestors and the path itself
+    List<OnGoingSubTreeOpsDTO> dtos = new ArrayList<>(ancestors.size());
+    try {
+      for (String key : ancestors) {
+        OnGoingSubTreeOpsDTO dto = session.newInstance(
+            OnGoingSubTreeOpsDTO.class, new Object[]{partitionId, key});
+        dto.setOpName(NOT_FOUND_ROW);
+        session.load(dto);
+        dtos.add(dto);
+      }
+      session.flush();
+      for (OnGoingSubTreeOpsDTO dto : dtos) {
+        if (dto.getOpName() != NOT_FOUND_ROW) {
+          return convert(dto);
+        }
+      }
+    } finally {
+      session.release(dtos);
+    }
+
+    // the first path after path + "/" is a descendant if there is any
+    String prefix = normalised + PathUtils.SEPARATOR;
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<OnGoingSubTreeOpsDTO> dobj =
+        qb.createQueryDefinition(OnGoingSubTreeOpsDTO.class);
+    HopsPredicate pred = dobj.get("partitionId")
+        .equal(dobj.param("partitionIDParam"))
+        .and(dobj.get("path").greaterEqual(dobj.param("prefix")));
+    dobj.where(pred);
+    HopsQuery<OnGoingSubTreeOpsDTO> query = session.createQuery(dobj);
+    query.setParameter("partitionIDParam", partitionId);
+    query.setParameter("prefix", prefix);
+    query.setOrdering(Query.Ordering.ASCENDING, "partitionId", "path");
+    query.setLimits(0, 1);
+    List<OnGoingSubTreeOpsDTO> descendants = query.getResultList();
+    try {
+      if (!descendants.isEmpty() &&
+          descendants.get(0).getPath().startsWith(prefix)) {
+        return convert(descendants.get(0));
+      }
+      return null;
+    } finally {
+      session.release(descendants);
+    }
+  }
+
   private List<SubTreeOperation> convertAndRelease(HopsSession session,
       Collection<OnGoingSubTreeOpsDTO> dtos) throws StorageException {
     List<SubTreeOperation> list = new ArrayList<>();
@@ -209,12 +289,16 @@ public class OnGoingSubTreeOpsClusterj
 
   private SubTreeOperation convertAndRelease(HopsSession session,
       OnGoingSubTreeOpsDTO opsDto) throws StorageException {
-    SubTreeOperation subTreeOperation = new SubTreeOperation(opsDto.getPath(),
+    SubTreeOperation subTreeOperation = convert(opsDto);
+    session.release(opsDto);
+    return subTreeOperation;
+  }
+
+  private SubTreeOperation convert(OnGoingSubTreeOpsDTO opsDto) {
+    return new SubTreeOperation(opsDto.getPath(),
         opsDto.getInodeId(), opsDto.getNamenodeId(), SubTreeOperation.Type.values()
         [opsDto.getOpName()], opsDto.getStartTime(),
             opsDto.getUser(), opsDto.getAsyncLockRecoveryTime());
-    session.release(opsDto);
-    return subTreeOperation;
   }
 
   private void createPersistableSubTreeOp(SubTreeOperation op,
@@ -21,6 +21,7 @@ package io.hops.metadata.ndb.dalimpl.hdfs;
 import com.google.common.collect.Sets;
 import com.google.common.primitives.Ints;
 import com.google.common.primitives.Longs;
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.Index;
 import com.mysql.clusterj.annotation.PartitionKey;
@@ -37,11 +38,13 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.util.LongLongHashMap;
 
 import java.sql.ResultSet;
 import java.sql.SQLException;
 import java.util.ArrayList;
 import java.util.Collection;
+import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
@@ -163,7 +166,60 @@ public class ReplicaClusterj
     }
     return result;
   }
-  
+
+  /**
+   * Bulk variant of {@link #findBlockAndInodeIdsByStorageId(int)}. The
+   * (blockId, inodeId) pairs are copied from the streamed result set straight
+   * into a primitive map, no DTO or Replica is created per row.
+   */
+  public LongLongHashMap findBlockAndInodeIdsByStorageIdBulk(int storageId)
+      throws StorageException {
+    return readBlockAndInodeIds(String.format("SELECT %s, %s FROM %s " +
+        "WHERE %s=%d", BLOCK_ID, INODE_ID, TABLE_NAME, STORAGE_ID, storageId));
+  }
+
+  /**
+   * Bulk variant of
+   * {@link #findBlockAndInodeIdsByStorageIdAndBucketId(int, int)}.
+   */
+  public LongLongHashMap findBlockAndInodeIdsByStorageIdAndBucketIdBulk(
+      int storageId, int bucketId) throws StorageException {
+    return readBlockAndInodeIds(String.format("SELECT %s, %s FROM %s " +
+        "WHERE %s=%d AND %s=%d", BLOCK_ID, INODE_ID, TABLE_NAME, STORAGE_ID,
+        storageId, BUCKET_ID, bucketId));
+  }
+
+  /**
+   * Bulk variant of
+   * {@link #findBlockAndInodeIdsByStorageIdAndBucketIds(int, List)} that
+   * reads all the given buckets with a single query instead of one query per
+   * bucket.
+   */
+  public LongLongHashMap findBlockAndInodeIdsByStorageIdAndBucketIdsBulk(
+      int storageId, int[] bucketIds) throws StorageException {
+    if (bucketIds.length == 0) {
+      return new LongLongHashMap();
+    }
+    return readBlockAndInodeIds(String.format("SELECT %s, %s FROM %s " +
+        "WHERE %s=%d AND %s IN (%s)", BLOCK_ID, INODE_ID, TABLE_NAME,
+        STORAGE_ID, storageId, BUCKET_ID, Ints.join(",", bucketIds)));
+  }
+
+  private static LongLongHashMap readBlockAndInodeIds(String query)
+      throws StorageException {
+    return MySQLQueryHelper.executeStreaming(query,
+        new MySQLQueryHelper.ResultSetHandler<LongLongHashMap>() {
+          @Override
+          public LongLongHashMap handle(ResultSet result) throws SQLException {
+            LongLongHashMap blockInodeMap = new LongLongHashMap();
+            while (result.next()) {
+              blockInodeMap.put(result.getLong(1), result.getLong(2));
+            }
+            return blockInodeMap;
+          }
+        });
+  }
+
   @Override
   public void prepare(Collection<Replica> removed,
       Collection<Replica> newed, Collection<Replica> modified)
@@ -197,6 +253,30 @@ public class ReplicaClusterj
     }
   }
   
+  /**
+   * Inserts a stream of new replicas through several concurrent sessions, see
+   * {@link BulkLoader}. Replicas are partitioned on their inode id, the
+   * distribution key of the table. Add the replicas to the returned loader
+   * and call {@link BulkLoader#finish()} once done.
+   */
+  public BulkLoader<Replica> bulkInsert(int threads, int batchSize,
+      int queueDepth) {
+    return new BulkLoader<Replica>("Replicas", threads, batchSize,
+        queueDepth) {
+      @Override
+      protected long partitionKey(Replica replica) {
+        return replica.getInodeId();
+      }
+
+      @Override
+      protected void write(HopsSession session, List<Replica> batch)
+          throws StorageException {
+        prepare(Collections.<Replica>emptyList(), batch,
+            Collections.<Replica>emptyList());
+      }
+    };
+  }
+
   @Override
   public Map<Long, Long> findBlockAndInodeIdsByStorageIdAndBucketIds(
       int sId, List<Integer> mismatchedBuckets) throws StorageException {
@@ -262,16 +342,31 @@ public class ReplicaClusterj
     return query.getResultList();
   }
 
+  /**
+   * Returns the replicas of the first non empty window [from + k * size,
+   * from + (k + 1) * size] of the storage. The window is located with a
+   * single ordered index lookup of the first block at or after from, instead
+   * of counting the blocks of every empty window.
+   */
   protected static List<ReplicaClusterj.ReplicaDTO> getReplicas(
       HopsSession session, int storageId, long from, int size) throws StorageException {
-    while(countBlocksInWindow(storageId, from, size)==0){
-      from+=size;
+    List<ReplicaDTO> first = getReplicasPage(session, storageId, from - 1, 1);
+    if (first.isEmpty()) {
+      return first;
+    }
+    long firstBlockId = first.get(0).getBlockId();
+    session.release(first);
+    if (firstBlockId - from > size) {
+      long skippedWindows = (firstBlockId - from + size - 1) / size - 1;
+      from += skippedWindows * size;
     }
     HopsQueryBuilder qb = session.getQueryBuilder();
     HopsQueryDomainType<ReplicaDTO> dobj =
         qb.createQueryDefinition(ReplicaClusterj.ReplicaDTO.class);
-    dobj.where(dobj.get("storageId").equal(dobj.param("storageId")));
-    dobj.where(dobj.get("blockId").between(dobj.param("minBlockId"), dobj.param("maxBlockId")));
+    HopsPredicate pred1 = dobj.get("storageId").equal(dobj.param("storageId"));
+    HopsPredicate pred2 = dobj.get("blockId").between(dobj.param("minBlockId"),
+        dobj.param("maxBlockId"));
+    dobj.where(pred1.and(pred2));
     HopsQuery<ReplicaDTO> query = session.createQuery(dobj);
     query.setParameter("storageId", storageId);
     query.setParameter("minBlockId", from);
@@ -279,19 +374,57 @@ public class ReplicaClusterj
     return query.getResultList();
   }
 
-  @Override
-  public boolean hasBlocksWithIdGreaterThan(int storageId, long from) throws StorageException {
-    HopsSession session = connector.obtainSession();
+  /**
+   * Keyset pagination over the (storage_id, block_id) index. Returns at most
+   * limit replicas of the storage with a block id strictly greater than
+   * afterBlockId, in block id order. The next page is read by passing the
+   * block id of the last returned replica.
+   */
+  protected static List<ReplicaClusterj.ReplicaDTO> getReplicasPage(
+      HopsSession session, int storageId, long afterBlockId, int limit)
+      throws StorageException {
     HopsQueryBuilder qb = session.getQueryBuilder();
     HopsQueryDomainType<ReplicaDTO> dobj =
         qb.createQueryDefinition(ReplicaClusterj.ReplicaDTO.class);
-    dobj.where(dobj.get("storageId").equal(dobj.param("storageId")));
-    dobj.where(dobj.get("blockId").greaterEqual(dobj.param("minBlockId")));
+    HopsPredicate pred1 = dobj.get("storageId").equal(dobj.param("storageId"));
+    HopsPredicate pred2 = dobj.get("blockId").greaterThan(dobj.param("afterBlockId"));
+    dobj.where(pred1.and(pred2));
     HopsQuery<ReplicaDTO> query = session.createQuery(dobj);
     query.setParameter("storageId", storageId);
-    query.setParameter("minBlockId", from);
-    query.setLimits(0, 1);
-    List<ReplicaDTO> dtos = query.getResultList();
+    query.setParameter("afterBlockId", afterBlockId);
+    query.setOrdering(Query.Ordering.ASCENDING, "storageId", "blockId");
+    query.setLimits(0, limit);
+    return query.getResultList();
+  }
+
+  /**
+   * Reads the next page of (blockId, inodeId) pairs of a storage into the
+   * given arrays, in block id order, see
+   * {@link #getReplicasPage(HopsSession, int, long, int)}. At most
+   * blockIds.length pairs are read.
+   *
+   * @return the number of pairs read, 0 once the storage is exhausted
+   */
+  public int findBlockAndInodeIdsByStorageIdAfter(int storageId,
+      long afterBlockId, long[] blockIds, long[] inodeIds)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    List<ReplicaDTO> dtos = getReplicasPage(session, storageId, afterBlockId,
+        blockIds.length);
+    int i = 0;
+    for (ReplicaDTO dto : dtos) {
+      blockIds[i] = dto.getBlockId();
+      inodeIds[i] = dto.getINodeId();
+      i++;
+    }
+    session.release(dtos);
+    return i;
+  }
+
+  @Override
+  public boolean hasBlocksWithIdGreaterThan(int storageId, long from) throws StorageException {
+    HopsSession session = connector.obtainSession();
+    List<ReplicaDTO> dtos = getReplicasPage(session, storageId, from - 1, 1);
     boolean result = !dtos.isEmpty();
     session.release(dtos);
     return result;
@@ -300,46 +433,27 @@ public class ReplicaClusterj
   @Override  
   public long findBlockIdAtIndex(int storageId, long index, int maxFetchingSize) throws StorageException{
     HopsSession session = connector.obtainSession();
-    
-    long startId=0;
-    long nbBlocks=0;
-    long prevStartId = 0;
-    long prevNbBlocks = 0;
-    int windowSize = maxFetchingSize * 1000;
-    while (windowSize > maxFetchingSize) {
-      while (nbBlocks < index) {
-        prevStartId = startId;
-        prevNbBlocks = nbBlocks;
-        nbBlocks += countBlocksInWindow(storageId, startId, windowSize);
-        startId += windowSize;
-
-      }
-      nbBlocks = prevNbBlocks;
-      startId = prevStartId;
-      windowSize = windowSize/10;
-    }
-      
-    while(nbBlocks<index){
-      List<ReplicaClusterj.ReplicaDTO> list = getReplicas(session, storageId, prevStartId, maxFetchingSize);
-      for(ReplicaDTO dto:list){
-        nbBlocks++;
-        if(nbBlocks==index){
-          return dto.getBlockId();
+    long nbBlocks = 0;
+    long lastBlockId = Long.MIN_VALUE;
+    while (nbBlocks < index) {
+      List<ReplicaDTO> page = getReplicasPage(session, storageId, lastBlockId,
+          maxFetchingSize);
+      try {
+        if (page.isEmpty()) {
+          return 0;
+        }
+        if (nbBlocks + page.size() >= index) {
+          return page.get((int) (index - nbBlocks - 1)).getBlockId();
         }
+        nbBlocks += page.size();
+        lastBlockId = page.get(page.size() - 1).getBlockId();
+      } finally {
+        session.release(page);
       }
-      startId+=maxFetchingSize;
     }
     return 0;
   }
   
-  private static Long countBlocksInWindow(int storageId, long from, int size) throws
-      StorageException {
-    Long result =  MySQLQueryHelper.executeLongAggrQuery(String.format("SELECT count(*) " +
-        "FROM %s WHERE %s='%d' and %s>='%d' and %s<=%d",TABLE_NAME, STORAGE_ID, storageId, BLOCK_ID,
-        from, BLOCK_ID, from+size));
-    return result;
-  }
-  
   private List<Replica> convertAndRelease(HopsSession session,
       List<ReplicaDTO> triplets) throws StorageException {
     List<Replica> replicas =
@@ -26,12 +26,33 @@ import io.hops.metadata.hdfs.entity.RetryCacheEntry;
 import io.hops.metadata.ndb.ClusterjConnector;
 import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
 import io.hops.metadata.ndb.wrapper.*;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
 
 import java.util.*;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
 
 public class RetryCacheEntryClusterj
     implements TablesDef.RetryCacheEntryTableDef, RetryCacheEntryDataAccess<RetryCacheEntry> {
 
+  static final Log LOG = LogFactory.getLog(RetryCacheEntryClusterj.class);
+
+  private static final int EXPIRY_CHUNK_SIZE = 1000;
+
+  private static final ExecutorService EXPIRY_EXECUTOR =
+      Executors.newSingleThreadExecutor(new ThreadFactory() {
+        @Override
+        public Thread newThread(Runnable r) {
+          Thread thread = new Thread(r, "Retry Cache Expiry Daemon");
+          thread.setDaemon(true);
+          return thread;
+        }
+      });
+
   private ClusterjConnector connector = ClusterjConnector.getInstance();
 
   @PersistenceCapable(table = TABLE_NAME)
@@ -72,6 +93,33 @@ public class RetryCacheEntryClusterj
     void setState(byte state);
   }
 
+  /**
+   * The primary key columns only, so that expiring an epoch does not read the
+   * payloads of the rows it deletes.
+   */
+  @PersistenceCapable(table = TABLE_NAME)
+  @PartitionKey(column = EPOCH)
+  public interface RetryCacheEntryKeyDTO {
+
+    @PrimaryKey
+    @Column(name = CLIENTID)
+    byte[] getClientId();
+
+    void setClientId(byte[] clientId);
+
+    @PrimaryKey
+    @Column(name = CALLID)
+    int getCallId();
+
+    void setCallId(int callId);
+
+    @PrimaryKey
+    @Column(name = EPOCH)
+    long getEpoch();
+
+    void setEpoch(long epoch);
+  }
+
   @Override
   public RetryCacheEntry find(RetryCacheEntry.PrimaryKey key) throws
       StorageException {
@@ -126,6 +174,86 @@ public class RetryCacheEntryClusterj
     return query.deletePersistentAll();
   }
 
+  /**
+   * Deletes the entries of an epoch in chunks of at most chunkSize rows, each
+   * chunk read by primary key with a limited scan and deleted in its own
+   * short transaction, so that expiring a large epoch does
+   * not hold locks on all its rows at once. An epoch lives in a single
+   * partition, so the chunks are read from one fragment. When called inside
+   * an active transaction the epoch is deleted in that transaction, as
+   * {@link #removeOlds(long)} does.
+   *
+   * @return the number of deleted entries
+   */
+  public int removeOldsInChunks(long epoch, int chunkSize)
+      throws StorageException {
+    if (chunkSize <= 0) {
+      throw new IllegalArgumentException("chunk size must be positive: " +
+          chunkSize);
+    }
+    HopsSession session = connector.obtainSession();
+    if (session.currentTransaction().isActive()) {
+      return removeOlds(epoch);
+    }
+    int total = 0;
+    int deleted;
+    do {
+      session.currentTransaction().begin();
+      try {
+        HopsQueryBuilder qb = session.getQueryBuilder();
+        HopsQueryDomainType<RetryCacheEntryKeyDTO> qdt =
+            qb.createQueryDefinition(RetryCacheEntryKeyDTO.class);
+        qdt.where(qdt.get("epoch").equal(qdt.param("param")));
+        HopsQuery<RetryCacheEntryKeyDTO> query = session.createQuery(qdt);
+        query.setParameter("param", epoch);
+        // the keys of the next chunk, deleted by primary key below
+        query.setLimits(0, chunkSize);
+        List<RetryCacheEntryKeyDTO> keys = query.getResultList();
+        deleted = keys.size();
+        try {
+          session.deletePersistentAll(keys);
+        } finally {
+          session.release(keys);
+        }
+        session.currentTransaction().commit();
+      } catch (StorageException e) {
+        if (session.currentTransaction().isActive()) {
+          session.currentTransaction().rollback();
+        }
+        throw e;
+      }
+      total += deleted;
+    } while (deleted == chunkSize);
+    return total;
+  }
+
+  /**
+   * Expires an epoch on a background thread, see
+   * {@link #removeOldsInChunks(long, int)}, so that the caller does not wait
+   * for, or hold a transaction open during, the deletion.
+   */
+  public Future<Integer> removeOldsInBackground(final long epoch) {
+    return EXPIRY_EXECUTOR.submit(new Callable<Integer>() {
+      @Override
+      public Integer call() throws StorageException {
+        boolean error = false;
+        try {
+          int deleted = removeOldsInChunks(epoch, EXPIRY_CHUNK_SIZE);
+          LOG.debug("Expired " + deleted + " retry cache entries of epoch " +
+              epoch);
+          return deleted;
+        } catch (StorageException e) {
+          error = true;
+          LOG.warn("Failed to expire the retry cache entries of epoch " +
+              epoch, e);
+          throw e;
+        } finally {
+          connector.returnSession(error);
+        }
+      }
+    });
+  }
+
   @Override
   public int count() throws StorageException {
     return MySQLQueryHelper.countAll(TABLE_NAME);
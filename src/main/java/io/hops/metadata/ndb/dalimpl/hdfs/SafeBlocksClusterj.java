@@ -66,6 +66,28 @@ public class SafeBlocksClusterj
     }
   }
   
+  /**
+   * Inserts a stream of safe block ids through several concurrent sessions,
+   * see {@link BulkLoader}. Add the ids to the returned loader and call
+   * {@link BulkLoader#finish()} once done.
+   */
+  public BulkLoader<Long> bulkInsert(int threads, int batchSize,
+      int queueDepth) {
+    return new BulkLoader<Long>("Safe Blocks", threads, batchSize,
+        queueDepth) {
+      @Override
+      protected long partitionKey(Long blockId) {
+        return blockId;
+      }
+
+      @Override
+      protected void write(HopsSession session, List<Long> batch)
+          throws StorageException {
+        insert(batch);
+      }
+    };
+  }
+
   @Override
   public boolean isSafe(Long BlockId) throws StorageException {
     HopsSession session = connector.obtainSession();
@@ -26,6 +26,7 @@ import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.StorageIdMapDataAccess;
 import io.hops.metadata.hdfs.entity.StorageId;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.StorageSnapshotCache;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
@@ -66,20 +67,50 @@ public class StorageIdMapClusterj
     }finally {
       session.release(sdto);
     }
+    StoragesClusterj.invalidateSnapshot();
   }
 
   @Override
   public StorageId findByPk(String storageId) throws StorageException {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      StorageId cached = cache.getSnapshot(StoragesClusterj.SNAPSHOT_LOADER)
+          .getStorageId(storageId);
+      if (cached != null) {
+        cache.recordHit();
+        return copy(cached);
+      }
+      cache.recordMiss();
+    }
     HopsSession session = connector.obtainSession();
     StorageIdDTO sdto = session.find(StorageIdDTO.class, storageId);
     if (sdto == null) {
       return null;
     }
+    if (cache != null) {
+      // mapped by another namenode since the snapshot was built
+      StoragesClusterj.invalidateSnapshot();
+    }
     return convertAndRelease(session, sdto);
   }
 
   @Override
   public Collection<StorageId> findAll() throws StorageException {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      cache.recordHit();
+      Collection<StorageId> cached = cache.getSnapshot(
+          StoragesClusterj.SNAPSHOT_LOADER).getStorageIds();
+      List<StorageId> copies = new ArrayList<>(cached.size());
+      for (StorageId storageId : cached) {
+        copies.add(copy(storageId));
+      }
+      return copies;
+    }
+    return readAll();
+  }
+
+  Collection<StorageId> readAll() throws StorageException {
     HopsSession session = connector.obtainSession();
     HopsQueryBuilder qb = session.getQueryBuilder();
     HopsQueryDomainType<StorageIdDTO> qdt =
@@ -88,6 +119,13 @@ public class StorageIdMapClusterj
     return convertAndRelease(session, q.getResultList());
   }
 
+  /**
+   * Snapshot entries are shared by all threads, callers get their own copy.
+   */
+  private static StorageId copy(StorageId storageId) {
+    return new StorageId(storageId.getStorageId(), storageId.getsId());
+  }
+
   private Collection<StorageId> convertAndRelease(HopsSession session,
       List<StorageIdDTO> dtos) throws StorageException {
     List<StorageId> hopstorageId = new ArrayList<>();
@@ -15,6 +15,7 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.LockMode;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
@@ -22,7 +23,10 @@ import io.hops.exception.StorageException;
 import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.StorageDataAccess;
 import io.hops.metadata.hdfs.entity.Storage;
+import io.hops.metadata.hdfs.entity.StorageId;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.CacheStats;
+import io.hops.metadata.ndb.cache.StorageSnapshotCache;
 import io.hops.metadata.ndb.wrapper.HopsPredicate;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
@@ -74,20 +78,53 @@ public class StoragesClusterj implements TablesDef.StoragesTableDef,
     sdto.setState(s.getState());
     session.savePersistent(sdto);
     session.release(sdto);
+    invalidateSnapshot();
   }
 
   @Override
   public Storage findByPk(int storageId) throws StorageException {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      Storage storage =
+          cache.getSnapshot(SNAPSHOT_LOADER).getStorage(storageId);
+      if (storage != null) {
+        cache.recordHit();
+        return copy(storage);
+      }
+      cache.recordMiss();
+    }
     HopsSession session = connector.obtainSession();
     StorageDTO sdto = session.find(StorageDTO.class, storageId);
     if (sdto == null) {
       return null;
     }
+    if (cache != null) {
+      // registered by another namenode since the snapshot was built
+      invalidateSnapshot();
+    }
     return convertAndRelease(session, sdto);
   }
 
   @Override
   public List<Storage> findByHostUuid(String uuid) throws StorageException {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      List<Storage> storages =
+          cache.getSnapshot(SNAPSHOT_LOADER).getStoragesOfHost(uuid);
+      if (!storages.isEmpty()) {
+        cache.recordHit();
+        return copy(storages);
+      }
+      cache.recordMiss();
+    }
+    List<Storage> storages = readByHostUuid(uuid);
+    if (cache != null && !storages.isEmpty()) {
+      invalidateSnapshot();
+    }
+    return storages;
+  }
+
+  private List<Storage> readByHostUuid(String uuid) throws StorageException {
     HopsSession session = connector.obtainSession();
     HopsQueryBuilder qb = session.getQueryBuilder();
     HopsQueryDomainType<StorageDTO> dobj =
@@ -105,6 +142,70 @@ public class StoragesClusterj implements TablesDef.StoragesTableDef,
 
   @Override
   public Collection<Storage> findAll() throws StorageException {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      cache.recordHit();
+      return copy(cache.getSnapshot(SNAPSHOT_LOADER).getStorages());
+    }
+    return readAll();
+  }
+
+  /**
+   * Rebuilds the storage snapshot from full scans of hdfs_storages and
+   * hdfs_storage_id_map. The scans do not take row locks, whatever the lock
+   * mode of the transaction that triggered the rebuild.
+   */
+  static final StorageSnapshotCache.Loader SNAPSHOT_LOADER =
+      new StorageSnapshotCache.Loader() {
+        @Override
+        public Collection<Storage> loadStorages() throws StorageException {
+          HopsSession session = ClusterjConnector.getInstance().obtainSession();
+          LockMode lockMode = session.getCurrentLockMode();
+          try {
+            session.setLockMode(LockMode.READ_COMMITTED);
+            return new StoragesClusterj().readAll();
+          } finally {
+            session.setLockMode(lockMode);
+          }
+        }
+
+        @Override
+        public Collection<StorageId> loadStorageIds()
+            throws StorageException {
+          HopsSession session = ClusterjConnector.getInstance().obtainSession();
+          LockMode lockMode = session.getCurrentLockMode();
+          try {
+            session.setLockMode(LockMode.READ_COMMITTED);
+            return new StorageIdMapClusterj().readAll();
+          } finally {
+            session.setLockMode(lockMode);
+          }
+        }
+      };
+
+  /**
+   * Invalidates the storage snapshot once the current transaction ends, so
+   * that a rebuild cannot pick up the tables from before the commit.
+   */
+  static void invalidateSnapshot() throws StorageException {
+    final StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    if (cache != null) {
+      ClusterjConnector.getInstance().obtainSession().afterTransaction(
+          new Runnable() {
+            @Override
+            public void run() {
+              cache.invalidate();
+            }
+          });
+    }
+  }
+
+  public static CacheStats getCacheStats() {
+    StorageSnapshotCache cache = StorageSnapshotCache.getInstance();
+    return cache == null ? null : cache.getStats();
+  }
+
+  Collection<Storage> readAll() throws StorageException {
     HopsSession session = connector.obtainSession();
     HopsQueryBuilder qb = session.getQueryBuilder();
     HopsQueryDomainType<StorageDTO> qdt =
@@ -136,6 +237,22 @@ public class StoragesClusterj implements TablesDef.StoragesTableDef,
     return storage;
   }
 
+  /**
+   * Snapshot entries are shared by all threads, callers get their own copy.
+   */
+  private static Storage copy(Storage storage) {
+    return new Storage(storage.getStorageID(), storage.getHostID(),
+        storage.getStorageType(), storage.getState());
+  }
+
+  private static List<Storage> copy(List<Storage> storages) {
+    List<Storage> copies = new ArrayList<>(storages.size());
+    for (Storage storage : storages) {
+      copies.add(copy(storage));
+    }
+    return copies;
+  }
+
   private Storage create(StorageDTO dto) {
     Storage storage = new Storage(
         dto.getStorageId(),
@@ -20,6 +20,7 @@ package io.hops.metadata.ndb.dalimpl.hdfs;
 
 import com.google.common.primitives.Ints;
 import com.google.common.primitives.Longs;
+import com.mysql.clusterj.LockMode;
 import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.Index;
@@ -166,13 +167,16 @@ public class UnderReplicatedBlockClusterj
 
   private UnderReplicatedBlock convertAndRelease(HopsSession session,
       UnderReplicatedBlocksDTO bit) throws StorageException {
-    UnderReplicatedBlock block =
-        new UnderReplicatedBlock(bit.getLevel(), bit.getBlockId(),
-            bit.getINodeId(), bit.getExpectedReplicas());
+    UnderReplicatedBlock block = convert(bit);
     session.release(bit);
     return block;
   }
 
+  private UnderReplicatedBlock convert(UnderReplicatedBlocksDTO bit) {
+    return new UnderReplicatedBlock(bit.getLevel(), bit.getBlockId(),
+        bit.getINodeId(), bit.getExpectedReplicas());
+  }
+
   private List<UnderReplicatedBlock> convertAndRelease(HopsSession session,
       List<UnderReplicatedBlocksDTO> bitList) throws StorageException {
     List<UnderReplicatedBlock> blocks = new ArrayList<>();
@@ -229,6 +233,231 @@ public class UnderReplicatedBlockClusterj
     return convertAndRelease(session, query.getResultList());
   }
 
+  /**
+   * One batch of a cursor scan of the replication queues, see
+   * {@link #findNextBatch(String, int, int)}.
+   */
+  public static class Batch {
+    private final List<UnderReplicatedBlock> blocks;
+    private final String resumeToken;
+
+    Batch(List<UnderReplicatedBlock> blocks, String resumeToken) {
+      this.blocks = blocks;
+      this.resumeToken = resumeToken;
+    }
+
+    public List<UnderReplicatedBlock> getBlocks() {
+      return blocks;
+    }
+
+    /**
+     * @return the token to pass to the next call, or null once every level
+     * has been scanned
+     */
+    public String getResumeToken() {
+      return resumeToken;
+    }
+  }
+
+  /**
+   * Position of a scan over the (level, timestamp, inode_id, block_id)
+   * index. Its string form is the opaque resume token handed to callers, so
+   * that they can persist it between replication monitor cycles.
+   */
+  private static class ScanPosition {
+    private int level;
+    private long timestamp = Long.MIN_VALUE;
+    private long inodeId = Long.MIN_VALUE;
+    private long blockId = Long.MIN_VALUE;
+
+    static ScanPosition parse(String token) throws StorageException {
+      ScanPosition position = new ScanPosition();
+      if (token == null) {
+        return position;
+      }
+      String[] parts = token.split(":");
+      if (parts.length != 4) {
+        throw new StorageException("Invalid resume token: " + token);
+      }
+      try {
+        position.level = Integer.parseInt(parts[0]);
+        position.timestamp = Long.parseLong(parts[1]);
+        position.inodeId = Long.parseLong(parts[2]);
+        position.blockId = Long.parseLong(parts[3]);
+      } catch (NumberFormatException e) {
+        throw new StorageException("Invalid resume token: " + token);
+      }
+      return position;
+    }
+
+    void moveTo(UnderReplicatedBlocksDTO dto) {
+      timestamp = dto.getTimestamp();
+      inodeId = dto.getINodeId();
+      blockId = dto.getBlockId();
+    }
+
+    void nextLevel() {
+      level++;
+      timestamp = Long.MIN_VALUE;
+      inodeId = Long.MIN_VALUE;
+      blockId = Long.MIN_VALUE;
+    }
+
+    @Override
+    public String toString() {
+      return level + ":" + timestamp + ":" + inodeId + ":" + blockId;
+    }
+  }
+
+  /**
+   * Returns up to count blocks in priority order, level by level and by
+   * insertion time within a level, starting after the position encoded in
+   * resumeToken (null to start from the highest priority). Every batch is a
+   * bounded index range scan that resumes from the last returned key, so
+   * deep batches do not re-read the earlier rows like offset paging does.
+   *
+   * @param maxLevel
+   *     the levels scanned are 0 to maxLevel - 1
+   */
+  public Batch findNextBatch(String resumeToken, int maxLevel, int count)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    ScanPosition position = ScanPosition.parse(resumeToken);
+    List<UnderReplicatedBlock> blocks = new ArrayList<>(count);
+
+    while (position.level < maxLevel && blocks.size() < count) {
+      if (position.timestamp != Long.MIN_VALUE) {
+        // rows inserted in the same millisecond as the last returned one
+        List<UnderReplicatedBlocksDTO> ties =
+            scanTies(session, position, count - blocks.size());
+        try {
+          for (UnderReplicatedBlocksDTO dto : ties) {
+            blocks.add(convert(dto));
+            position.moveTo(dto);
+          }
+        } finally {
+          session.release(ties);
+        }
+        if (blocks.size() == count) {
+          break;
+        }
+      }
+
+      int remaining = count - blocks.size();
+      List<UnderReplicatedBlocksDTO> dtos = scanLevel(session, position.level,
+          position.timestamp, remaining);
+      try {
+        for (UnderReplicatedBlocksDTO dto : dtos) {
+          blocks.add(convert(dto));
+          position.moveTo(dto);
+        }
+        if (dtos.size() < remaining) {
+          position.nextLevel();
+        }
+      } finally {
+        session.release(dtos);
+      }
+    }
+
+    return new Batch(blocks,
+        position.level < maxLevel ? position.toString() : null);
+  }
+
+  /**
+   * Reads and deletes up to count of the highest priority blocks in one
+   * transaction. The rows are read with an exclusive lock so that concurrent
+   * callers never pop the same block. Joins the current transaction if there
+   * is one.
+   */
+  public List<UnderReplicatedBlock> popHighestPriority(int maxLevel, int count)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    boolean activeTx = session.currentTransaction().isActive();
+    LockMode lockMode = session.getCurrentLockMode();
+    List<UnderReplicatedBlocksDTO> popped = new ArrayList<>(count);
+    try {
+      if (!activeTx) {
+        session.currentTransaction().begin();
+      }
+      session.setLockMode(LockMode.EXCLUSIVE);
+      for (int level = 0; level < maxLevel && popped.size() < count; level++) {
+        popped.addAll(scanLevel(session, level, Long.MIN_VALUE,
+            count - popped.size()));
+      }
+      List<UnderReplicatedBlock> blocks = new ArrayList<>(popped.size());
+      for (UnderReplicatedBlocksDTO dto : popped) {
+        blocks.add(convert(dto));
+      }
+      session.deletePersistentAll(popped);
+      if (!activeTx) {
+        session.currentTransaction().commit();
+      }
+      return blocks;
+    } catch (Throwable t) {
+      if (!activeTx && session.currentTransaction().isActive()) {
+        session.currentTransaction().rollback();
+      }
+      throw t;
+    } finally {
+      session.setLockMode(lockMode);
+      session.release(popped);
+    }
+  }
+
+  /**
+   * Ordered scan of the rows of the position's level and timestamp that come
+   * after its (inode_id, block_id), on the (level, timestamp, inode_id,
+   * block_id) index. The inode_id lower bound keeps the range tight, the
+   * block_id comparison only filters the rows of that inode.
+   */
+  private List<UnderReplicatedBlocksDTO> scanTies(HopsSession session,
+      ScanPosition position, int limit) throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<UnderReplicatedBlocksDTO> dobj =
+        qb.createQueryDefinition(UnderReplicatedBlocksDTO.class);
+    HopsPredicate after = dobj.get("iNodeId").greaterThan(dobj.param("inodeId"))
+        .or(dobj.get("iNodeId").equal(dobj.param("inodeId"))
+            .and(dobj.get("blockId").greaterThan(dobj.param("blockId"))));
+    dobj.where(dobj.get("level").equal(dobj.param("level"))
+        .and(dobj.get("timestamp").equal(dobj.param("timestamp")))
+        .and(dobj.get("iNodeId").greaterEqual(dobj.param("inodeId")))
+        .and(after));
+    HopsQuery<UnderReplicatedBlocksDTO> query = session.createQuery(dobj);
+    query.setParameter("level", position.level);
+    query.setParameter("timestamp", position.timestamp);
+    query.setParameter("inodeId", position.inodeId);
+    query.setParameter("blockId", position.blockId);
+    query.setOrdering(Query.Ordering.ASCENDING, "level", "timestamp",
+        "iNodeId", "blockId");
+    query.setLimits(0, limit);
+    return query.getResultList();
+  }
+
+  /**
+   * Ordered scan of one level of the (level, timestamp, inode_id, block_id)
+   * index, of the rows after the given timestamp. A limit of 0 reads every
+   * matching row.
+   */
+  private List<UnderReplicatedBlocksDTO> scanLevel(HopsSession session,
+      int level, long timestamp, int limit) throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<UnderReplicatedBlocksDTO> dobj =
+        qb.createQueryDefinition(UnderReplicatedBlocksDTO.class);
+    HopsPredicate pred1 = dobj.get("level").equal(dobj.param("level"));
+    HopsPredicate pred2 =
+        dobj.get("timestamp").greaterThan(dobj.param("timestamp"));
+    dobj.where(pred1.and(pred2));
+    HopsQuery<UnderReplicatedBlocksDTO> query = session.createQuery(dobj);
+    query.setParameter("level", level);
+    query.setParameter("timestamp", timestamp);
+    query.setOrdering(Query.Ordering.ASCENDING, "level", "timestamp",
+        "iNodeId", "blockId");
+    if (limit > 0) {
+      query.setLimits(0, limit);
+    }
+    return query.getResultList();
+  }
+
   @Override
   public List<UnderReplicatedBlock> findByINodeId(long inodeId)
       throws StorageException {
@@ -26,6 +26,7 @@ import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.UserDataAccess;
 import io.hops.metadata.hdfs.entity.User;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.UserGroupCache;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
@@ -55,20 +56,41 @@ public class UserClusterj implements TablesDef.UsersTableDef, UserDataAccess<Use
 
   @Override
   public User getUser(final int userId) throws StorageException {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      User cached = cache.getUser(userId);
+      if (cached != null) {
+        return cached;
+      }
+    }
     HopsSession session = connector.obtainSession();
     UserDTO dto = session.find(UserDTO.class, userId);
     User user = null;
     if(dto != null) {
       user = new User(dto.getId(), dto.getName());
       session.release(dto);
+      if (cache != null) {
+        cache.putUser(user);
+      }
     }
     return user;
   }
 
   @Override
   public User getUser(final String userName) throws StorageException {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      User cached = cache.getUser(userName);
+      if (cached != null) {
+        return cached;
+      }
+    }
     HopsSession session = connector.obtainSession();
-    return getUser(session, userName);
+    User user = getUser(session, userName);
+    if (cache != null && user != null) {
+      cache.putUser(user);
+    }
+    return user;
   }
 
   @Override
@@ -84,7 +106,7 @@ public class UserClusterj implements TablesDef.UsersTableDef, UserDataAccess<Use
   }
 
   @Override
-  public void removeUser(int userId) throws StorageException {
+  public void removeUser(final int userId) throws StorageException {
     HopsSession session = connector.obtainSession();
     UserDTO dto = null;
     try {
@@ -93,6 +115,15 @@ public class UserClusterj implements TablesDef.UsersTableDef, UserDataAccess<Use
     }finally {
       session.release(dto);
     }
+    final UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      session.afterTransaction(new Runnable() {
+        @Override
+        public void run() {
+          cache.invalidateUser(userId);
+        }
+      });
+    }
   }
 
   private void addUser(HopsSession session, final String userName)
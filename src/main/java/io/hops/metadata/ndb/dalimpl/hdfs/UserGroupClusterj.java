@@ -28,6 +28,8 @@ import io.hops.metadata.hdfs.dal.UserGroupDataAccess;
 import io.hops.metadata.hdfs.entity.Group;
 import io.hops.metadata.hdfs.entity.User;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.cache.CacheStats;
+import io.hops.metadata.ndb.cache.UserGroupCache;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
@@ -85,6 +87,7 @@ public class UserGroupClusterj implements TablesDef.UsersGroupsTableDef,
     }finally {
       session.release(dtos);
     }
+    invalidateCache(session, userId);
   }
 
   @Override
@@ -95,6 +98,13 @@ public class UserGroupClusterj implements TablesDef.UsersGroupsTableDef,
   @Override
   public List<Group> getGroupsForUser(int userId)
       throws StorageException {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      List<Group> cached = cache.getGroupsForUser(userId);
+      if (cached != null) {
+        return cached;
+      }
+    }
     HopsSession session = connector.obtainSession();
 
     List<UserGroupDTO> userGroupDTOs = null;
@@ -118,7 +128,11 @@ public class UserGroupClusterj implements TablesDef.UsersGroupsTableDef,
       }
       session.flush();
 
-      return GroupClusterj.convert(session, groupDTOs);
+      List<Group> groups = GroupClusterj.convert(session, groupDTOs);
+      if (cache != null) {
+        cache.putGroupsForUser(userId, groups);
+      }
+      return groups;
     }finally {
       session.release(userGroupDTOs);
       session.release(groupDTOs);
@@ -140,6 +154,31 @@ public class UserGroupClusterj implements TablesDef.UsersGroupsTableDef,
     } finally {
       session.release(dto);
     }
+    invalidateCache(session, userId);
+  }
+
+  public static CacheStats getCacheStats() {
+    UserGroupCache cache = UserGroupCache.getInstance();
+    return cache == null ? null : cache.getStats();
+  }
+
+  /**
+   * Drops the cached memberships of the user once the transaction has ended,
+   * so that a concurrent lookup can not cache the memberships from before the
+   * commit, and a lookup inside the transaction can not keep its uncommitted
+   * ones after a rollback.
+   */
+  private static void invalidateCache(HopsSession session, final int userId)
+      throws StorageException {
+    final UserGroupCache cache = UserGroupCache.getInstance();
+    if (cache != null) {
+      session.afterTransaction(new Runnable() {
+        @Override
+        public void run() {
+          cache.invalidateGroupsForUser(userId);
+        }
+      });
+    }
   }
   
 }
@@ -18,10 +18,13 @@
  */
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
+import com.mysql.clusterj.LockMode;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
 import io.hops.exception.StorageException;
+import io.hops.metadata.common.entity.IntVariable;
+import io.hops.metadata.common.entity.LongVariable;
 import io.hops.metadata.common.entity.Variable;
 import io.hops.metadata.hdfs.TablesDef;
 import io.hops.metadata.hdfs.dal.VariableDataAccess;
@@ -84,6 +87,66 @@ public class VariableClusterj
     return var;
   }
 
+  /**
+   * Reserves count ids of a counter variable in one short transaction that
+   * holds the variable row only for a single read and write, independently
+   * of any transaction of the caller. The counter holds the last id handed
+   * out, so the reserved ids are first to first + count - 1 where first is
+   * the returned value.
+   */
+  public long allocateRange(Variable.Finder varType, long count)
+      throws StorageException {
+    if (count <= 0) {
+      throw new IllegalArgumentException("count must be positive: " + count);
+    }
+    HopsSession session = connector.obtainSession();
+    if (session.currentTransaction().isActive()) {
+      throw new StorageException("Id ranges of " + varType +
+          " must be allocated outside of a transaction");
+    }
+    LockMode lockMode = session.getCurrentLockMode();
+    VariableDTO vd = null;
+    try {
+      session.currentTransaction().begin();
+      session.setLockMode(LockMode.EXCLUSIVE);
+      vd = session.find(VariableDTO.class, varType.getId());
+      if (vd == null) {
+        throw new StorageException(
+            "There is no variable entry with id " + varType.getId());
+      }
+      Variable var = Variable.initVariable(varType, vd.getValue());
+      long last;
+      Variable next;
+      if (var instanceof LongVariable) {
+        last = ((LongVariable) var).getValue();
+        next = new LongVariable(varType, last + count);
+      } else if (var instanceof IntVariable) {
+        last = ((IntVariable) var).getValue();
+        if (last + count > Integer.MAX_VALUE) {
+          throw new StorageException("Variable " + varType + " overflows");
+        }
+        next = new IntVariable(varType, (int) (last + count));
+      } else {
+        throw new StorageException("Variable " + varType +
+            " is not a counter");
+      }
+      session.release(vd);
+      vd = null;
+      vd = createVariableDTO(session, next);
+      session.savePersistent(vd);
+      session.currentTransaction().commit();
+      return last + 1;
+    } catch (StorageException e) {
+      if (session.currentTransaction().isActive()) {
+        session.currentTransaction().rollback();
+      }
+      throw e;
+    } finally {
+      session.release(vd);
+      session.setLockMode(lockMode);
+    }
+  }
+
   @Override
   public void setVariable(Variable var) throws StorageException {
     HopsSession session = connector.obtainSession();
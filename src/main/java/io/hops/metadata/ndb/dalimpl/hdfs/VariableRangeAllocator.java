@@ -0,0 +1,141 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.dalimpl.hdfs;
+
+import io.hops.exception.StorageException;
+import io.hops.metadata.common.entity.Variable;
+import io.hops.metadata.ndb.ClusterjConnector;
+import org.apache.log4j.Logger;
+
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
+
+/**
+ * Hands out ids of a counter variable, such as inode ids, block ids or
+ * generation stamps, from ranges reserved with
+ * {@link VariableClusterj#allocateRange(Variable.Finder, long)}, so the
+ * variable row is read and written once per range instead of once per id.
+ * The next range is reserved in the background once the remaining ids of
+ * the current one fall below the prefetch threshold.
+ */
+public class VariableRangeAllocator {
+  static final Logger LOG = Logger.getLogger(VariableRangeAllocator.class);
+
+  private static final ExecutorService PREFETCH_EXECUTOR =
+      Executors.newCachedThreadPool(new ThreadFactory() {
+        @Override
+        public Thread newThread(Runnable r) {
+          Thread thread = new Thread(r, "Variable Range Prefetch Daemon");
+          thread.setDaemon(true);
+          return thread;
+        }
+      });
+
+  private final VariableClusterj variables;
+  private final Variable.Finder varType;
+  private final long rangeSize;
+  private final long prefetchThreshold;
+
+  private long next = 0;
+  private long end = 0;
+  private Future<Long> prefetched = null;
+
+  /**
+   * @param prefetchThreshold
+   *     number of remaining ids in the current range below which the next
+   *     range is reserved in the background, 0 disables prefetching
+   */
+  public VariableRangeAllocator(VariableClusterj variables,
+      Variable.Finder varType, long rangeSize, long prefetchThreshold) {
+    if (rangeSize <= 0) {
+      throw new IllegalArgumentException("range size must be positive: " +
+          rangeSize);
+    }
+    this.variables = variables;
+    this.varType = varType;
+    this.rangeSize = rangeSize;
+    this.prefetchThreshold = Math.min(prefetchThreshold, rangeSize);
+  }
+
+  public synchronized long nextId() throws StorageException {
+    if (next == end) {
+      long first = prefetched != null ? takePrefetched() :
+          await(allocate());
+      next = first;
+      end = first + rangeSize;
+    }
+    long id = next++;
+    if (end - next < prefetchThreshold && prefetched == null) {
+      prefetched = allocate();
+    }
+    return id;
+  }
+
+  /**
+   * Reserves the next range on the executor. nextId is usually called inside
+   * the transaction of the caller and allocateRange needs a session without
+   * an active transaction, so a range is never reserved on the calling
+   * thread.
+   */
+  private Future<Long> allocate() {
+    return PREFETCH_EXECUTOR.submit(new Callable<Long>() {
+      @Override
+      public Long call() throws StorageException {
+        boolean error = false;
+        try {
+          return variables.allocateRange(varType, rangeSize);
+        } catch (StorageException e) {
+          error = true;
+          throw e;
+        } finally {
+          ClusterjConnector.getInstance().returnSession(error);
+        }
+      }
+    });
+  }
+
+  private long takePrefetched() throws StorageException {
+    Future<Long> future = prefetched;
+    prefetched = null;
+    try {
+      return await(future);
+    } catch (StorageException e) {
+      LOG.warn("Prefetching a range of " + varType + " failed", e);
+      return await(allocate());
+    }
+  }
+
+  private static long await(Future<Long> future) throws StorageException {
+    try {
+      return future.get();
+    } catch (InterruptedException e) {
+      Thread.currentThread().interrupt();
+      throw new StorageException(e);
+    } catch (ExecutionException e) {
+      if (e.getCause() instanceof StorageException) {
+        throw (StorageException) e.getCause();
+      }
+      throw new StorageException(e.getCause());
+    }
+  }
+}
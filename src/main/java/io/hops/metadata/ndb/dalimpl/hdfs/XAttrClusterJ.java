@@ -18,7 +18,7 @@
 package io.hops.metadata.ndb.dalimpl.hdfs;
 
 import com.google.common.collect.Lists;
-import com.google.common.primitives.Bytes;
+import com.mysql.clusterj.Query;
 import com.mysql.clusterj.annotation.Column;
 import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
@@ -37,9 +37,9 @@ import org.apache.log4j.Logger;
 
 import java.util.ArrayList;
 import java.util.Collection;
-import java.util.Collections;
-import java.util.Comparator;
 import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.LinkedHashSet;
 import java.util.List;
 import java.util.Map;
 
@@ -87,54 +87,75 @@ public class XAttrClusterJ implements TablesDef.XAttrTableDef,
   }
   
   private ClusterjConnector connector = ClusterjConnector.getInstance();
-  private short NON_EXISTS_XATTR = -1;
   
+  // xattrs read by one scan, bounds the size of its OR predicate
+  private static final int MAX_KEYS_PER_SCAN = 100;
+
+  /**
+   * Reads all the parts of the requested xattrs with ordered scans of the
+   * primary key, one range per xattr and at most MAX_KEYS_PER_SCAN xattrs per
+   * scan, instead of reading part 0 first to learn the number of parts. The
+   * returned xattrs follow the order of pks, xattrs that do not exist are
+   * skipped.
+   */
   @Override
   public List<StoredXAttr> getXAttrsByPrimaryKeyBatch(
       List<StoredXAttr.PrimaryKey> pks) throws StorageException {
+    List<StoredXAttr> xattrs = Lists.newArrayListWithExpectedSize(pks.size());
+    if (pks.isEmpty()) {
+      return xattrs;
+    }
+    List<StoredXAttr.PrimaryKey> uniquePks =
+        new ArrayList<>(new LinkedHashSet<>(pks));
+    
     HopsSession session = connector.obtainSession();
-    List<XAttrDTO> dtos = Lists.newArrayListWithExpectedSize(pks.size());
-    List<List<XAttrDTO>> partsDtos = Lists.newArrayListWithCapacity(pks.size());
-    try {
-      
-      short index = 0;
-      for (StoredXAttr.PrimaryKey pk : pks) {
-        XAttrDTO dto = session.newInstance(XAttrDTO.class,
-            new Object[]{pk.getInodeId(), pk.getNamespace(), pk.getName(), index});
-        dto.setNumParts(NON_EXISTS_XATTR);
-        session.load(dto);
-        dtos.add(dto);
-      }
-      session.flush();
-  
-      
-      for(XAttrDTO dto : dtos){
-        //check if the row exists
-        if(dto.getNumParts() != NON_EXISTS_XATTR) {
-          List<XAttrDTO> pdtos =
-              Lists.newArrayListWithExpectedSize(dto.getNumParts());
-          pdtos.add(dto);
-          for(short i=1; i<dto.getNumParts(); i++){
-            XAttrDTO partDto = session.newInstance(XAttrDTO.class,
-                new Object[]{dto.getINodeId(), dto.getNamespace(),
-                    dto.getName(), i});
-            partDto.setNumParts(NON_EXISTS_XATTR);
-            session.load(partDto);
-            pdtos.add(partDto);
-          }
-          partsDtos.add(pdtos);
-        }
-      }
-      
-      session.flush();
-      
-      return convertBatch(session, partsDtos);
-    }finally {
-      session.release(dtos);
-      for(List<XAttrDTO> dtoList : partsDtos){
-        session.release(dtoList);
+    Map<StoredXAttr.PrimaryKey, StoredXAttr> xattrsByPk =
+        new HashMap<>(uniquePks.size());
+    for (int from = 0; from < uniquePks.size(); from += MAX_KEYS_PER_SCAN) {
+      xattrsByPk.putAll(readOrdered(session, uniquePks.subList(from,
+          Math.min(from + MAX_KEYS_PER_SCAN, uniquePks.size()))));
+    }
+    for (StoredXAttr.PrimaryKey pk : pks) {
+      StoredXAttr xattr = xattrsByPk.get(pk);
+      if (xattr != null) {
+        xattrs.add(xattr);
       }
     }
+    return xattrs;
+  }
+
+  private Map<StoredXAttr.PrimaryKey, StoredXAttr> readOrdered(
+      HopsSession session, List<StoredXAttr.PrimaryKey> pks)
+      throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<XAttrDTO> dobj =
+        qb.createQueryDefinition(XAttrDTO.class);
+    HopsPredicate pred = null;
+    for (int i = 0; i < pks.size(); i++) {
+      HopsPredicate pkPred = dobj.get("iNodeId").equal(dobj.param("idParam" + i))
+          .and(dobj.get("namespace").equal(dobj.param("nsParam" + i)))
+          .and(dobj.get("name").equal(dobj.param("nameParam" + i)));
+      pred = pred == null ? pkPred : pred.or(pkPred);
+    }
+    dobj.where(pred);
+    
+    HopsQuery<XAttrDTO> query = session.createQuery(dobj);
+    for (int i = 0; i < pks.size(); i++) {
+      StoredXAttr.PrimaryKey pk = pks.get(i);
+      query.setParameter("idParam" + i, pk.getInodeId());
+      query.setParameter("nsParam" + i, pk.getNamespace());
+      query.setParameter("nameParam" + i, pk.getName());
+    }
+    query.setOrdering(Query.Ordering.ASCENDING, "iNodeId", "namespace",
+        "name", "index");
+    
+    List<XAttrDTO> results = null;
+    try {
+      results = query.getResultList();
+      return convertOrdered(results);
+    } finally {
+      session.release(results);
+    }
   }
   
   @Override
@@ -148,6 +169,8 @@ public class XAttrClusterJ implements TablesDef.XAttrTableDef,
   
     HopsQuery<XAttrDTO> query = session.createQuery(dobj);
     query.setParameter("idParam", inodeId);
+    query.setOrdering(Query.Ordering.ASCENDING, "iNodeId", "namespace",
+        "name", "index");
   
     List<XAttrDTO> results = null;
     try {
@@ -155,7 +178,7 @@ public class XAttrClusterJ implements TablesDef.XAttrTableDef,
       if (results.isEmpty()) {
         return null;
       }
-      return convertByInode(session, results);
+      return new ArrayList<>(convertOrdered(results).values());
     }finally {
       session.release(results);
     }
@@ -250,78 +273,65 @@ public class XAttrClusterJ implements TablesDef.XAttrTableDef,
     return xAttrDTOS;
   }
   
-  private List<StoredXAttr> convertBatch(HopsSession session,
-      List<List<XAttrDTO>> dtos) throws StorageException {
-    List<StoredXAttr> results = Lists.newArrayListWithExpectedSize(dtos.size());
-    for(List<XAttrDTO> dtoList : dtos){
-      results.add(convert(session, dtoList));
-    }
-    return results;
-  }
-  
-  private List<StoredXAttr> convertByInode(HopsSession session,
-      List<XAttrDTO> dtos) throws StorageException {
-    List<StoredXAttr> results = Lists.newArrayList();
-    Map<StoredXAttr.PrimaryKey, List<XAttrDTO>> xAttrsByPk = new HashMap<>();
-    for(XAttrDTO dto : dtos){
-      StoredXAttr.PrimaryKey pk = new StoredXAttr.PrimaryKey(dto.getINodeId()
-          , dto.getNamespace(), dto.getName());
-      if(!xAttrsByPk.containsKey(pk)){
-        xAttrsByPk.put(pk, new ArrayList<XAttrDTO>());
-      }
-      xAttrsByPk.get(pk).add(dto);
-    }
-    
-    for(Map.Entry<StoredXAttr.PrimaryKey, List<XAttrDTO>> entry :
-        xAttrsByPk.entrySet()){
-      List<XAttrDTO> xAttrDTOS = entry.getValue();
-      Collections.sort(xAttrDTOS, new Comparator<XAttrDTO>() {
-        @Override
-        public int compare(XAttrDTO o1, XAttrDTO o2) {
-          return Short.compare(o1.getIndex(), o2.getIndex());
+  /**
+   * Reassembles xattrs from their parts. The dtos must be ordered by primary
+   * key so that the parts of an xattr are adjacent and in index order.
+   */
+  private Map<StoredXAttr.PrimaryKey, StoredXAttr> convertOrdered(
+      List<XAttrDTO> dtos) {
+    Map<StoredXAttr.PrimaryKey, StoredXAttr> xattrs = new LinkedHashMap<>();
+    int start = 0;
+    while (start < dtos.size()) {
+      XAttrDTO first = dtos.get(start);
+      byte[][] parts = new byte[Math.max(first.getNumParts(), 1)][];
+      int end = start;
+      while (end < dtos.size() && samePrimaryKey(first, dtos.get(end))) {
+        XAttrDTO dto = dtos.get(end);
+        // parts beyond numParts are leftovers of a larger value
+        if (dto.getIndex() < parts.length) {
+          parts[dto.getIndex()] = dto.getValue();
         }
-      });
+        end++;
+      }
+      start = end;
       
-      results.add(convert(session, xAttrDTOS));
-    }
-    return results;
-  }
-  
-  private StoredXAttr convert(HopsSession session, List<XAttrDTO> dtos)
-      throws StorageException {
-    byte[][] values = new byte[dtos.size()][];
-    short index = 0;
-    int nulls = 0;
-    for(XAttrDTO dto : dtos){
-      if(dto.getNumParts() != NON_EXISTS_XATTR){
-        values[index] = dto.getValue();
-      }else{
-        XAttrDTO partDto = session.find(XAttrDTO.class,
-            new Object[]{dto.getINodeId(), dto.getNamespace(),
-                dto.getName(), index});
-        values[index] = partDto.getValue();
+      int nulls = 0;
+      int length = 0;
+      for (byte[] part : parts) {
+        if (part == null) {
+          nulls++;
+        } else {
+          length += part.length;
+        }
       }
-      if(values[index] == null){
-        nulls++;
+      
+      byte[] value;
+      if (nulls == 0) {
+        value = new byte[length];
+        int offset = 0;
+        for (byte[] part : parts) {
+          System.arraycopy(part, 0, value, offset, part.length);
+          offset += part.length;
+        }
+      } else if (nulls == parts.length) {
+        value = null;
+      } else {
+        throw new IllegalStateException("Failed to read XAttr [ " +
+            first.getName() + " ] for Inode " + first.getINodeId() +
+            " because " + nulls + " parts were null.");
       }
-      index++;
+      
+      xattrs.put(new StoredXAttr.PrimaryKey(first.getINodeId(),
+          first.getNamespace(), first.getName()), new StoredXAttr(
+          first.getINodeId(), first.getNamespace(), first.getName(), value));
     }
+    return xattrs;
+  }
   
-    XAttrDTO dto = dtos.get(0);
-    
-    byte[] value;
-    if(nulls == 0){
-      value = Bytes.concat(values);
-    }else if(nulls == dtos.size()){
-      value = null;
-    }else{
-      throw new IllegalStateException("Failed to read XAttr [ " + dto.getName()
-          +  " ] for Inode " + dto.getINodeId() + " because " + nulls +
-          " parts were null.");
-    }
-    
-    return new StoredXAttr(dto.getINodeId(), dto.getNamespace(),
-        dto.getName(), value);
+  private static boolean samePrimaryKey(XAttrDTO a, XAttrDTO b) {
+    return a.getINodeId() == b.getINodeId() &&
+        a.getNamespace() == b.getNamespace() &&
+        a.getName().equals(b.getName());
   }
   
 }
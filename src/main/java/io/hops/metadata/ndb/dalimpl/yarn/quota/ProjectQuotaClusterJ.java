@@ -23,6 +23,7 @@ import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
 import io.hops.exception.StorageException;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
 import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
@@ -30,6 +31,8 @@ import io.hops.metadata.ndb.wrapper.HopsSession;
 import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.quota.ProjectQuotaDataAccess;
 import io.hops.metadata.yarn.entity.quota.ProjectQuota;
+import java.sql.Connection;
+import java.sql.SQLException;
 import java.util.ArrayList;
 import java.util.Collection;
 import java.util.HashMap;
@@ -128,6 +131,64 @@ public class ProjectQuotaClusterJ implements TablesDef.ProjectQuotaTableDef,
 
   }
 
+  /**
+   * Adds the remaining and used quota of each given ProjectQuota, taken as
+   * deltas, to the stored values of its project with a single multi-row
+   * upsert. Projects that have no row yet are created with the deltas as
+   * their values. Nothing is read back, so callers no longer need to load
+   * the whole table to recompute the totals.
+   * <p/>
+   * The statement goes through the MySQL server and is not part of the
+   * current ClusterJ transaction.
+   */
+  public void accumulateAll(Collection<ProjectQuota> deltas)
+          throws StorageException {
+    if (deltas.isEmpty()) {
+      return;
+    }
+    List<Object> params = new ArrayList<>(deltas.size() * 3);
+    MySQLQueryHelper.execute(accumulateQuery(deltas, params), params);
+  }
+
+  /**
+   * Same as {@link #accumulateAll(Collection)} on the given connection, so
+   * that the upsert is part of the caller's MySQL server transaction.
+   */
+  void accumulateAll(Connection conn, Collection<ProjectQuota> deltas)
+          throws SQLException {
+    if (deltas.isEmpty()) {
+      return;
+    }
+    List<Object> params = new ArrayList<>(deltas.size() * 3);
+    MySQLQueryHelper.executeUpdate(conn, accumulateQuery(deltas, params),
+            params);
+  }
+
+  private static String accumulateQuery(Collection<ProjectQuota> deltas,
+          List<Object> params) {
+    StringBuilder query = new StringBuilder("INSERT INTO ").append(TABLE_NAME)
+            .append(" (").append(PROJECT_NAME).append(", ")
+            .append(REMAINING_QUOTA).append(", ").append(TOTAL_USED_QUOTA)
+            .append(") VALUES ");
+    for (ProjectQuota delta : deltas) {
+      if (!params.isEmpty()) {
+        query.append(", ");
+      }
+      query.append("(?, ?, ?)");
+      params.add(delta.getProjectid());
+      params.add(delta.getRemainingQuota());
+      params.add(delta.getTotalUsedQuota());
+    }
+    query.append(" ON DUPLICATE KEY UPDATE ")
+            .append(accumulate(REMAINING_QUOTA)).append(", ")
+            .append(accumulate(TOTAL_USED_QUOTA));
+    return query.toString();
+  }
+
+  static String accumulate(String column) {
+    return column + " = IFNULL(" + column + ", 0) + VALUES(" + column + ")";
+  }
+
   private ProjectQuotaDTO createPersistable(ProjectQuota hopPQ,
           HopsSession session) throws StorageException {
     ProjectQuotaDTO pqDTO = session.newInstance(ProjectQuotaDTO.class);
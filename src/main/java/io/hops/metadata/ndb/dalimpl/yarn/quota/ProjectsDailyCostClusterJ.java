@@ -23,6 +23,7 @@ import com.mysql.clusterj.annotation.PersistenceCapable;
 import com.mysql.clusterj.annotation.PrimaryKey;
 import io.hops.exception.StorageException;
 import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
 import io.hops.metadata.ndb.wrapper.HopsPredicate;
 
 import io.hops.metadata.ndb.wrapper.HopsQuery;
@@ -33,9 +34,12 @@ import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.quota.ProjectsDailyCostDataAccess;
 import io.hops.metadata.yarn.entity.quota.ProjectDailyCost;
 import io.hops.metadata.yarn.entity.quota.ProjectDailyId;
+import java.sql.Connection;
+import java.sql.SQLException;
 import java.util.ArrayList;
 
 import java.util.Collection;
+import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
@@ -78,6 +82,8 @@ public class ProjectsDailyCostClusterJ implements
 
   }
 
+  private static final int APP_IDS_MAX_LENGTH = 3000;
+
   private final ClusterjConnector connector = ClusterjConnector.getInstance();
 
     @Override 
@@ -176,6 +182,84 @@ public class ProjectsDailyCostClusterJ implements
     session.release(toAdd);
   }
 
+  /**
+   * Adds the credits used of each given ProjectDailyCost, taken as a delta,
+   * to the stored value of its (project, user, day) with a single multi-row
+   * upsert. Each application id of a delta is added to the stored list
+   * unless the list already holds exactly that id, up to the length cap of
+   * the column.
+   * <p/>
+   * The statement goes through the MySQL server and is not part of the
+   * current ClusterJ transaction.
+   */
+  public void accumulateAll(Collection<ProjectDailyCost> deltas)
+          throws StorageException {
+    if (deltas.isEmpty()) {
+      return;
+    }
+    List<Object> params = new ArrayList<>(deltas.size() * 5);
+    MySQLQueryHelper.execute(accumulateQuery(deltas, params), params);
+  }
+
+  /**
+   * Same as {@link #accumulateAll(Collection)} on the given connection, so
+   * that the upsert is part of the caller's MySQL server transaction.
+   */
+  void accumulateAll(Connection conn, Collection<ProjectDailyCost> deltas)
+          throws SQLException {
+    if (deltas.isEmpty()) {
+      return;
+    }
+    List<Object> params = new ArrayList<>(deltas.size() * 5);
+    MySQLQueryHelper.executeUpdate(conn, accumulateQuery(deltas, params),
+            params);
+  }
+
+  /**
+   * One row per application id of a delta, the credits being carried by the
+   * first one. The rows of a key are applied in order, so each id is tested
+   * for membership on its own with FIND_IN_SET, which matches whole list
+   * elements only.
+   */
+  private static String accumulateQuery(Collection<ProjectDailyCost> deltas,
+          List<Object> params) {
+    StringBuilder query = new StringBuilder("INSERT INTO ").append(TABLE_NAME)
+            .append(" (").append(PROJECTNAME).append(", ").append(USER)
+            .append(", ").append(DAY).append(", ").append(CREDITS_USED)
+            .append(", ").append(APP_IDS).append(") VALUES ");
+    for (ProjectDailyCost delta : deltas) {
+      float credits = delta.getCreditsUsed();
+      Collection<String> appIds = delta.getAppIds().isEmpty() ?
+              Collections.singletonList("") : delta.getAppIds();
+      for (String appId : appIds) {
+        if (!params.isEmpty()) {
+          query.append(", ");
+        }
+        query.append("(?, ?, ?, ?, ?)");
+        params.add(delta.getProjectName());
+        params.add(delta.getProjectUser());
+        params.add(delta.getDay());
+        params.add(credits);
+        params.add(appId.isEmpty() ? "" : appId + ',');
+        credits = 0;
+      }
+    }
+    // every list ends with a separator, so appending is a plain CONCAT
+    String appId = "TRIM(TRAILING ',' FROM VALUES(" + APP_IDS + "))";
+    String merged = "CONCAT(IFNULL(" + APP_IDS + ", ''), VALUES(" + APP_IDS +
+            "))";
+    query.append(" ON DUPLICATE KEY UPDATE ")
+            .append(ProjectQuotaClusterJ.accumulate(CREDITS_USED)).append(", ")
+            .append(APP_IDS).append(" = IF(").append(appId)
+            .append(" = '' OR FIND_IN_SET(").append(appId).append(", ")
+            .append(APP_IDS).append(") > 0, ").append(APP_IDS)
+            .append(", IF(LENGTH(").append(merged).append(") > ")
+            .append(APP_IDS_MAX_LENGTH).append(", CONCAT(LEFT(")
+            .append(merged).append(", ").append(APP_IDS_MAX_LENGTH - 3)
+            .append("), '...'), ").append(merged).append("))");
+    return query.toString();
+  }
+
   private ProjectDailyCostDTO createPersistable(
           ProjectDailyCost hopPQ, HopsSession session) throws
           StorageException {
@@ -187,14 +271,27 @@ public class ProjectsDailyCostClusterJ implements
     pqDTO.setUser(hopPQ.getProjectUser());
     pqDTO.setDay(hopPQ.getDay());
     pqDTO.setCreditUsed(hopPQ.getCreditsUsed());
-    String appIds = "";
-    for(String appId: hopPQ.getAppIds()){
-        appIds = appIds + appId + ",";
+    pqDTO.setAppIds(toAppIds(hopPQ));
+    return pqDTO;
+  }
+
+  static String toAppIds(ProjectDailyCost hopPQ) {
+    String appIds = joinAppIds(hopPQ.getAppIds());
+    if(appIds.length()>APP_IDS_MAX_LENGTH){
+        appIds = appIds.substring(0, APP_IDS_MAX_LENGTH - 3) +"...";
     }
-    if(appIds.length()>3000){
-        appIds = appIds.substring(0, 2997) +"...";
+    return appIds;
+  }
+
+  /**
+   * @return the ids in the stored format, each followed by a separator,
+   * without the length cap
+   */
+  static String joinAppIds(Collection<String> ids) {
+    StringBuilder appIds = new StringBuilder();
+    for (String appId : ids) {
+      appIds.append(appId).append(',');
     }
-    pqDTO.setAppIds(appIds);
-    return pqDTO;
+    return appIds.toString();
   }
 }
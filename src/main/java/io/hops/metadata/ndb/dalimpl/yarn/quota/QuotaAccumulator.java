@@ -0,0 +1,215 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.dalimpl.yarn.quota;
+
+import io.hops.exception.StorageException;
+import io.hops.metadata.ndb.mysqlserver.MySQLQueryHelper;
+import io.hops.metadata.yarn.entity.quota.ProjectDailyCost;
+import io.hops.metadata.yarn.entity.quota.ProjectDailyId;
+import io.hops.metadata.yarn.entity.quota.ProjectQuota;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.sql.Connection;
+import java.sql.SQLException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.UUID;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Coalesces quota and daily cost deltas locally and writes them with
+ * {@link ProjectQuotaClusterJ#accumulateAll} and
+ * {@link ProjectsDailyCostClusterJ#accumulateAll}, so that a project charged
+ * several times within a window costs a single row in the batch.
+ * <p/>
+ * Deltas are written when {@link #flush()} is called or, if a window was
+ * given, every window ms by a daemon thread. The deltas of a flush are
+ * written in one MySQL server transaction together with a row keyed by the
+ * id of the flush. A failed flush is retried as it was, with the same id,
+ * before any new delta, so a retry of a flush whose commit was in doubt
+ * finds its row and does not count the deltas twice. Flush rows are kept for
+ * a day.
+ */
+public class QuotaAccumulator {
+
+  static final Log LOG = LogFactory.getLog(QuotaAccumulator.class);
+
+  private static final String FLUSHES_TABLE = "yarn_quota_flushes";
+  private static final String FLUSH_ID = "flush_id";
+  private static final String TIME = "time";
+  private static final long FLUSH_RETENTION = TimeUnit.DAYS.toMillis(1);
+
+  private final ProjectQuotaClusterJ quotaDA;
+  private final ProjectsDailyCostClusterJ dailyCostDA;
+  private final ScheduledExecutorService flusher;
+
+  private Map<String, ProjectQuota> quotaDeltas = new HashMap<>();
+  private Map<ProjectDailyId, ProjectDailyCost> costDeltas = new HashMap<>();
+
+  private final Object flushLock = new Object();
+  // the last flush, if it failed, guarded by flushLock
+  private Flush failed = null;
+
+  private static class Flush {
+    final String id = UUID.randomUUID().toString();
+    final List<ProjectQuota> quotas;
+    final List<ProjectDailyCost> costs;
+
+    Flush(List<ProjectQuota> quotas, List<ProjectDailyCost> costs) {
+      this.quotas = quotas;
+      this.costs = costs;
+    }
+  }
+
+  /**
+   * @param windowMs
+   *     how often pending deltas are written in the background. 0 disables
+   *     background flushing.
+   */
+  public QuotaAccumulator(ProjectQuotaClusterJ quotaDA,
+          ProjectsDailyCostClusterJ dailyCostDA, long windowMs) {
+    this.quotaDA = quotaDA;
+    this.dailyCostDA = dailyCostDA;
+    if (windowMs > 0) {
+      flusher = Executors.newSingleThreadScheduledExecutor(
+              new ThreadFactory() {
+                @Override
+                public Thread newThread(Runnable r) {
+                  Thread t = new Thread(r, "Quota Accumulator Flusher");
+                  t.setDaemon(true);
+                  return t;
+                }
+              });
+      flusher.scheduleWithFixedDelay(new Runnable() {
+        @Override
+        public void run() {
+          try {
+            flush();
+          } catch (StorageException e) {
+            LOG.warn("Failed to flush quota deltas, will retry", e);
+          }
+        }
+      }, windowMs, windowMs, TimeUnit.MILLISECONDS);
+    } else {
+      flusher = null;
+    }
+  }
+
+  public synchronized void addQuota(ProjectQuota delta) {
+    ProjectQuota pending = quotaDeltas.get(delta.getProjectid());
+    if (pending != null) {
+      delta = new ProjectQuota(delta.getProjectid(),
+              pending.getRemainingQuota() + delta.getRemainingQuota(),
+              pending.getTotalUsedQuota() + delta.getTotalUsedQuota());
+    }
+    quotaDeltas.put(delta.getProjectid(), delta);
+  }
+
+  public synchronized void addDailyCost(ProjectDailyCost delta) {
+    ProjectDailyId id = new ProjectDailyId(delta.getProjectName(),
+            delta.getProjectUser(), delta.getDay());
+    ProjectDailyCost pending = costDeltas.get(id);
+    if (pending != null) {
+      Set<String> appIds = new LinkedHashSet<>(pending.getAppIds());
+      appIds.addAll(delta.getAppIds());
+      delta = new ProjectDailyCost(delta.getProjectName(),
+              delta.getProjectUser(), delta.getDay(),
+              pending.getCreditsUsed() + delta.getCreditsUsed(),
+              ProjectsDailyCostClusterJ.joinAppIds(appIds));
+    }
+    costDeltas.put(id, delta);
+  }
+
+  /**
+   * Writes all the pending deltas, one batch per table, after the deltas of
+   * the last flush if it failed.
+   */
+  public void flush() throws StorageException {
+    synchronized (flushLock) {
+      if (failed != null) {
+        write(failed);
+        failed = null;
+      }
+      Flush flush;
+      synchronized (this) {
+        if (quotaDeltas.isEmpty() && costDeltas.isEmpty()) {
+          return;
+        }
+        flush = new Flush(new ArrayList<>(quotaDeltas.values()),
+                new ArrayList<>(costDeltas.values()));
+        quotaDeltas = new HashMap<>();
+        costDeltas = new HashMap<>();
+      }
+      try {
+        write(flush);
+      } catch (Throwable t) {
+        failed = flush;
+        throw t;
+      }
+    }
+  }
+
+  /**
+   * Stops background flushing and writes the pending deltas.
+   */
+  public void close() throws StorageException {
+    if (flusher != null) {
+      flusher.shutdown();
+      try {
+        flusher.awaitTermination(1, TimeUnit.MINUTES);
+      } catch (InterruptedException e) {
+        Thread.currentThread().interrupt();
+      }
+    }
+    flush();
+  }
+
+  private void write(final Flush flush) throws StorageException {
+    MySQLQueryHelper.executeInTransaction(
+            new MySQLQueryHelper.TransactionHandler<Void>() {
+              @Override
+              public Void handle(Connection conn) throws SQLException {
+                long now = System.currentTimeMillis();
+                if (MySQLQueryHelper.executeUpdate(conn, "INSERT IGNORE INTO " +
+                        FLUSHES_TABLE + " (" + FLUSH_ID + ", " + TIME +
+                        ") VALUES (?, ?)", Arrays.asList(flush.id, now)) == 0) {
+                  LOG.info("Quota deltas of flush " + flush.id +
+                          " were already written");
+                  return null;
+                }
+                MySQLQueryHelper.executeUpdate(conn, "DELETE FROM " +
+                        FLUSHES_TABLE + " WHERE " + TIME + " < ?",
+                        Collections.singletonList(now - FLUSH_RETENTION));
+                quotaDA.accumulateAll(conn, flush.quotas);
+                dailyCostDA.accumulateAll(conn, flush.costs);
+                return null;
+              }
+            });
+  }
+}
@@ -28,6 +28,7 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.metadata.ndb.wrapper.PagedScan;
 import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.rmstatestore.ApplicationAttemptStateDataAccess;
 import io.hops.metadata.yarn.entity.rmstatestore.ApplicationAttemptState;
@@ -72,6 +73,17 @@ public class ApplicationAttemptStateClusterJ
 
   private final ClusterjConnector connector = ClusterjConnector.getInstance();
 
+  private static final PagedScan<ApplicationAttemptStateDTO> KEY_SCAN =
+      new PagedScan<ApplicationAttemptStateDTO>(
+          ApplicationAttemptStateDTO.class, "applicationid",
+          "applicationattemptid") {
+        @Override
+        protected Object[] key(ApplicationAttemptStateDTO row) {
+          return new Object[]{row.getapplicationid(),
+              row.getapplicationattemptid()};
+        }
+      };
+
   @Override
   public Map<String, List<ApplicationAttemptState>> getAll()
       throws StorageException {
@@ -87,6 +99,25 @@ public class ApplicationAttemptStateClusterJ
     return result;
   }
 
+  /**
+   * Hands every ApplicationAttemptState to the consumer, for recovery. The
+   * table is read in pages ordered on its primary key, see {@link PagedScan},
+   * and each page is released once converted, so only one page of rows is
+   * held at a time.
+   *
+   * @return the number of ApplicationAttemptStates read
+   */
+  public int streamAll(final RecoveryConsumer<ApplicationAttemptState> consumer)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    return KEY_SCAN.scan(session, new PagedScan.RowHandler<ApplicationAttemptStateDTO>() {
+      @Override
+      public void handle(ApplicationAttemptStateDTO row) throws StorageException {
+        consumer.consume(createHopApplicationAttemptState(row));
+      }
+    });
+  }
+
   @Override
   public List<ApplicationAttemptState> getByAppId(String appId) throws StorageException {
     HopsSession session = connector.obtainSession();
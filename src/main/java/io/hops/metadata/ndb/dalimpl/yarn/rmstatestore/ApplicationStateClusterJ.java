@@ -27,6 +27,7 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.metadata.ndb.wrapper.PagedScan;
 import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.rmstatestore.ApplicationStateDataAccess;
 import io.hops.metadata.yarn.entity.rmstatestore.ApplicationState;
@@ -73,6 +74,15 @@ public class ApplicationStateClusterJ implements
 
   private final ClusterjConnector connector = ClusterjConnector.getInstance();
 
+  private static final PagedScan<ApplicationStateDTO> KEY_SCAN =
+      new PagedScan<ApplicationStateDTO>(ApplicationStateDTO.class,
+          "applicationid") {
+        @Override
+        protected Object[] key(ApplicationStateDTO row) {
+          return new Object[]{row.getapplicationid()};
+        }
+      };
+
   @Override
   public ApplicationState findByApplicationId(String id)
       throws StorageException {
@@ -101,6 +111,25 @@ public class ApplicationStateClusterJ implements
     return result;
   }
 
+  /**
+   * Hands every ApplicationState to the consumer, for recovery. The table is
+   * read in pages ordered on its primary key, see {@link PagedScan}, and each
+   * page is released once converted, so only one page of rows is held at a
+   * time.
+   *
+   * @return the number of ApplicationStates read
+   */
+  public int streamAll(final RecoveryConsumer<ApplicationState> consumer)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    return KEY_SCAN.scan(session, new PagedScan.RowHandler<ApplicationStateDTO>() {
+      @Override
+      public void handle(ApplicationStateDTO row) throws StorageException {
+        consumer.consume(createHopApplicationState(row));
+      }
+    });
+  }
+
   @Override
   public void add(ApplicationState toAdd) throws StorageException {
     HopsSession session = connector.obtainSession();
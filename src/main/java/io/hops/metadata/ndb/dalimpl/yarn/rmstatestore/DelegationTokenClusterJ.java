@@ -27,6 +27,7 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.metadata.ndb.wrapper.PagedScan;
 import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.rmstatestore.DelegationTokenDataAccess;
 import io.hops.metadata.yarn.entity.rmstatestore.DelegationToken;
@@ -58,6 +59,14 @@ public class DelegationTokenClusterJ implements
 
   private final ClusterjConnector connector = ClusterjConnector.getInstance();
 
+  private static final PagedScan<DelegationTokenDTO> KEY_SCAN =
+      new PagedScan<DelegationTokenDTO>(DelegationTokenDTO.class, "seqnumber") {
+        @Override
+        protected Object[] key(DelegationTokenDTO row) {
+          return new Object[]{row.getseqnumber()};
+        }
+      };
+
   @Override
   public void add(DelegationToken hopDelegationToken)
       throws StorageException {
@@ -80,6 +89,25 @@ public class DelegationTokenClusterJ implements
     return result;
   }
 
+  /**
+   * Hands every DelegationToken to the consumer, for recovery. The table is
+   * read in pages ordered on its primary key, see {@link PagedScan}, and each
+   * page is released once converted, so only one page of rows is held at a
+   * time.
+   *
+   * @return the number of DelegationTokens read
+   */
+  public int streamAll(final RecoveryConsumer<DelegationToken> consumer)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    return KEY_SCAN.scan(session, new PagedScan.RowHandler<DelegationTokenDTO>() {
+      @Override
+      public void handle(DelegationTokenDTO row) throws StorageException {
+        consumer.consume(createHopDelegationToken(row));
+      }
+    });
+  }
+
   @Override
   public void remove(DelegationToken removed) throws StorageException {
     HopsSession session = connector.obtainSession();
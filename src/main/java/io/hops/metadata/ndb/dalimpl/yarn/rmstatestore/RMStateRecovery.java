@@ -0,0 +1,187 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.dalimpl.yarn.rmstatestore;
+
+import io.hops.exception.StorageException;
+import io.hops.metadata.ndb.ClusterjConnector;
+import io.hops.metadata.yarn.entity.rmstatestore.ApplicationAttemptState;
+import io.hops.metadata.yarn.entity.rmstatestore.ApplicationState;
+import io.hops.metadata.yarn.entity.rmstatestore.DelegationToken;
+import io.hops.metadata.yarn.entity.rmstatestore.ReservationState;
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Loads the ResourceManager state at failover. The application, attempt,
+ * delegation token and reservation tables are scanned concurrently, one
+ * thread and session each. Every scan reads its table in pages ordered on
+ * the primary key and hands the decoded state objects to its consumer one at
+ * a time, so neither the rows nor the state objects of a whole table are held
+ * at once. Each consumer is called from a single thread, but
+ * the consumers of different tables run concurrently. Progress can be polled
+ * while {@link #run()} is running.
+ */
+public class RMStateRecovery {
+  static final Log LOG = LogFactory.getLog(RMStateRecovery.class);
+
+  private final RecoveryConsumer<ApplicationState> applications;
+  private final RecoveryConsumer<ApplicationAttemptState> attempts;
+  private final RecoveryConsumer<DelegationToken> tokens;
+  private final RecoveryConsumer<ReservationState> reservations;
+
+  private final AtomicLong recoveredApplications = new AtomicLong(0);
+  private final AtomicLong recoveredAttempts = new AtomicLong(0);
+  private final AtomicLong recoveredTokens = new AtomicLong(0);
+  private final AtomicLong recoveredReservations = new AtomicLong(0);
+
+  public RMStateRecovery(RecoveryConsumer<ApplicationState> applications,
+      RecoveryConsumer<ApplicationAttemptState> attempts,
+      RecoveryConsumer<DelegationToken> tokens,
+      RecoveryConsumer<ReservationState> reservations) {
+    this.applications = applications;
+    this.attempts = attempts;
+    this.tokens = tokens;
+    this.reservations = reservations;
+  }
+
+  /**
+   * Runs the scans and waits for all of them to finish.
+   *
+   * @throws StorageException
+   *     the first failure of any of the scans or consumers
+   */
+  public void run() throws StorageException {
+    ExecutorService executor = Executors.newFixedThreadPool(4);
+    try {
+      List<Future<Integer>> scans = new ArrayList<>(4);
+      scans.add(executor.submit(new Scan() {
+        @Override
+        int scan() throws StorageException {
+          return new ApplicationStateClusterJ().streamAll(
+              counting(applications, recoveredApplications));
+        }
+      }));
+      scans.add(executor.submit(new Scan() {
+        @Override
+        int scan() throws StorageException {
+          return new ApplicationAttemptStateClusterJ().streamAll(
+              counting(attempts, recoveredAttempts));
+        }
+      }));
+      scans.add(executor.submit(new Scan() {
+        @Override
+        int scan() throws StorageException {
+          return new DelegationTokenClusterJ().streamAll(
+              counting(tokens, recoveredTokens));
+        }
+      }));
+      scans.add(executor.submit(new Scan() {
+        @Override
+        int scan() throws StorageException {
+          return new ReservationStateClusterJ().streamAll(
+              counting(reservations, recoveredReservations));
+        }
+      }));
+
+      StorageException failure = null;
+      for (Future<Integer> scan : scans) {
+        try {
+          scan.get();
+        } catch (ExecutionException e) {
+          if (failure == null) {
+            failure = e.getCause() instanceof StorageException ?
+                (StorageException) e.getCause() :
+                new StorageException(e.getCause());
+          }
+        } catch (InterruptedException e) {
+          Thread.currentThread().interrupt();
+          throw new StorageException(e);
+        }
+      }
+      if (failure != null) {
+        throw failure;
+      }
+      LOG.info("Recovered " + recoveredApplications.get() + " applications, " +
+          recoveredAttempts.get() + " attempts, " + recoveredTokens.get() +
+          " delegation tokens and " + recoveredReservations.get() +
+          " reservations");
+    } finally {
+      executor.shutdownNow();
+    }
+  }
+
+  public long getRecoveredApplications() {
+    return recoveredApplications.get();
+  }
+
+  public long getRecoveredAttempts() {
+    return recoveredAttempts.get();
+  }
+
+  public long getRecoveredTokens() {
+    return recoveredTokens.get();
+  }
+
+  public long getRecoveredReservations() {
+    return recoveredReservations.get();
+  }
+
+  private static <T> RecoveryConsumer<T> counting(
+      final RecoveryConsumer<T> consumer, final AtomicLong counter) {
+    return new RecoveryConsumer<T>() {
+      @Override
+      public void consume(T state) throws StorageException {
+        consumer.consume(state);
+        counter.incrementAndGet();
+      }
+    };
+  }
+
+  /**
+   * A table scan running on its own thread, with its own session that is
+   * returned to the pool when the scan ends.
+   */
+  private abstract static class Scan implements Callable<Integer> {
+
+    abstract int scan() throws StorageException;
+
+    @Override
+    public Integer call() throws StorageException {
+      ClusterjConnector connector = ClusterjConnector.getInstance();
+      boolean error = false;
+      try {
+        return scan();
+      } catch (StorageException e) {
+        error = true;
+        throw e;
+      } finally {
+        connector.returnSession(error);
+      }
+    }
+  }
+}
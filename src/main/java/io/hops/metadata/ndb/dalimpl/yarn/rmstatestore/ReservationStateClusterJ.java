@@ -27,6 +27,7 @@ import io.hops.metadata.ndb.wrapper.HopsQuery;
 import io.hops.metadata.ndb.wrapper.HopsQueryBuilder;
 import io.hops.metadata.ndb.wrapper.HopsQueryDomainType;
 import io.hops.metadata.ndb.wrapper.HopsSession;
+import io.hops.metadata.ndb.wrapper.PagedScan;
 import io.hops.metadata.yarn.TablesDef;
 import io.hops.metadata.yarn.dal.ReservationStateDataAccess;
 import io.hops.metadata.yarn.entity.rmstatestore.ReservationState;
@@ -61,6 +62,16 @@ public class ReservationStateClusterJ implements TablesDef.ReservationStateTable
 
   private final ClusterjConnector connector = ClusterjConnector.getInstance();
 
+  private static final PagedScan<ReservationStateDTO> KEY_SCAN =
+      new PagedScan<ReservationStateDTO>(ReservationStateDTO.class, "planName",
+          "reservationIdName") {
+        @Override
+        protected Object[] key(ReservationStateDTO row) {
+          return new Object[]{row.getPlanName(),
+              row.getReservationIdName()};
+        }
+      };
+
   @Override
   public List<ReservationState> getAll() throws StorageException {
 
@@ -74,6 +85,25 @@ public class ReservationStateClusterJ implements TablesDef.ReservationStateTable
     return result;
   }
 
+  /**
+   * Hands every ReservationState to the consumer, for recovery. The table is
+   * read in pages ordered on its primary key, see {@link PagedScan}, and each
+   * page is released once converted, so only one page of rows is held at a
+   * time.
+   *
+   * @return the number of ReservationStates read
+   */
+  public int streamAll(final RecoveryConsumer<ReservationState> consumer)
+      throws StorageException {
+    HopsSession session = connector.obtainSession();
+    return KEY_SCAN.scan(session, new PagedScan.RowHandler<ReservationStateDTO>() {
+      @Override
+      public void handle(ReservationStateDTO row) throws StorageException {
+        consumer.consume(createReservationState(row));
+      }
+    });
+  }
+
   @Override
   public void add(ReservationState state) throws StorageException {
     HopsSession session = connector.obtainSession();
@@ -25,6 +25,7 @@ import java.sql.Connection;
 import java.sql.PreparedStatement;
 import java.sql.ResultSet;
 import java.sql.SQLException;
+import java.util.List;
 import org.apache.commons.logging.Log;
 import org.apache.commons.logging.LogFactory;
 
@@ -110,6 +111,13 @@ public class MySQLQueryHelper {
     return executeLongAggrQuery(query.toString());
   }
   
+  public static long minLong(String tableName, String column)
+      throws StorageException {
+    StringBuilder query =
+        new StringBuilder(String.format(MIN, column, tableName));
+    return executeLongAggrQuery(query.toString());
+  }
+  
   public static long maxLong(String tableName, String column, String criterion)
       throws StorageException {
     StringBuilder query =
@@ -187,6 +195,88 @@ public class MySQLQueryHelper {
     }
   }
 
+  /**
+   * Executes an update statement with the given positional parameters bound
+   * in order to its '?' placeholders.
+   *
+   * @return the number of rows affected
+   */
+  public static int execute(String query, List<?> params)
+      throws StorageException {
+    PreparedStatement s = null;
+    try {
+      Connection conn = connector.obtainSession();
+      s = conn.prepareStatement(query);
+      for (int i = 0; i < params.size(); i++) {
+        s.setObject(i + 1, params.get(i));
+      }
+      return s.executeUpdate();
+    } catch (SQLException ex) {
+      throw HopsSQLExceptionHelper.wrap(ex);
+    } finally {
+      if (s != null) {
+        try {
+          s.close();
+        } catch (SQLException ex) {
+          LOG.warn("Exception when closing the PrepareStatement", ex);
+        }
+      }
+      connector.closeSession();
+    }
+  }
+
+  /**
+   * Executes an update statement on the given connection, see
+   * {@link #execute(String, List)}.
+   */
+  public static int executeUpdate(Connection conn, String query,
+      List<?> params) throws SQLException {
+    PreparedStatement s = conn.prepareStatement(query);
+    try {
+      for (int i = 0; i < params.size(); i++) {
+        s.setObject(i + 1, params.get(i));
+      }
+      return s.executeUpdate();
+    } finally {
+      s.close();
+    }
+  }
+
+  public interface TransactionHandler<R> {
+    R handle(Connection conn) throws SQLException, StorageException;
+  }
+
+  /**
+   * Runs the handler in a single MySQL server transaction, committed when
+   * the handler returns and rolled back if it throws.
+   */
+  public static <R> R executeInTransaction(TransactionHandler<R> handler)
+      throws StorageException {
+    try {
+      Connection conn = connector.obtainSession();
+      boolean autoCommit = conn.getAutoCommit();
+      conn.setAutoCommit(false);
+      try {
+        R result = handler.handle(conn);
+        conn.commit();
+        return result;
+      } catch (Throwable t) {
+        try {
+          conn.rollback();
+        } catch (SQLException ex) {
+          LOG.warn("Exception when rolling back the transaction", ex);
+        }
+        throw t;
+      } finally {
+        conn.setAutoCommit(autoCommit);
+      }
+    } catch (SQLException ex) {
+      throw HopsSQLExceptionHelper.wrap(ex);
+    } finally {
+      connector.closeSession();
+    }
+  }
+
   public interface ResultSetHandler<R> {
     R handle(ResultSet result) throws SQLException, StorageException;
   }
@@ -214,4 +304,34 @@ public class MySQLQueryHelper {
     }
   }
 
+  /**
+   * Same as {@link #execute(String, ResultSetHandler)} but the rows are
+   * streamed from the MySQL server one at a time instead of being buffered in
+   * the driver. The handler must consume the whole result set.
+   */
+  public static <R> R executeStreaming(String query,
+      ResultSetHandler<R> handler) throws StorageException {
+    try {
+      PreparedStatement s = null;
+      try {
+        Connection conn = connector.obtainSession();
+        s = conn.prepareStatement(query, ResultSet.TYPE_FORWARD_ONLY,
+            ResultSet.CONCUR_READ_ONLY);
+        s.setFetchSize(Integer.MIN_VALUE);
+        ResultSet result = s.executeQuery();
+        return handler.handle(result);
+      } catch (SQLException ex) {
+        throw HopsSQLExceptionHelper.wrap(ex);
+      } finally {
+        if (s != null) {
+          s.close();
+        }
+
+        connector.closeSession();
+      }
+    } catch (SQLException ex) {
+      throw new StorageException(ex);
+    }
+  }
+
 }
@@ -0,0 +1,161 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.wrapper;
+
+import org.apache.commons.logging.Log;
+import org.apache.commons.logging.LogFactory;
+
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.Collections;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Tracks the DTOs a session hands out during a transaction, so that the ones
+ * the DAL did not release are released when the transaction commits or
+ * rolls back. ClusterJ no longer releases DTOs on finalize, so a DTO that is
+ * not released leaks its native buffers.
+ * <p/>
+ * In {@link Mode#DEBUG} the allocation site of every DTO is recorded and the
+ * DTOs found unreleased at the end of a transaction are logged with it. The
+ * tracking maps of a session are cleared, not reallocated, between
+ * transactions.
+ */
+public class DTOArena {
+  static final Log LOG = LogFactory.getLog(DTOArena.class);
+
+  public enum Mode {
+    /** DTOs are only released by the DAL */
+    OFF,
+    /** unreleased DTOs are released at the end of the transaction */
+    ON,
+    /** as ON, and unreleased DTOs are logged with their allocation site */
+    DEBUG
+  }
+
+  private static volatile Mode mode = Mode.OFF;
+  private static final AtomicLong leaked = new AtomicLong(0);
+
+  // live DTOs, with their allocation site in DEBUG mode
+  private final Map<Object, Throwable> live = new IdentityHashMap<>();
+  // DTOs released at the end of the last transaction that left any, a later
+  // release of one of them by the DAL must not reach ClusterJ again. Only the
+  // last leaking transaction is kept, as a pooled session lives for good and
+  // most leaked DTOs are never released by the DAL.
+  private final Set<Object> retired =
+      Collections.newSetFromMap(new IdentityHashMap<Object, Boolean>());
+  private Mode transactionMode = Mode.OFF;
+
+  public static void configure(Mode newMode) {
+    mode = newMode;
+    if (newMode != Mode.OFF) {
+      LOG.info("DTO arena enabled, mode: " + newMode);
+    }
+  }
+
+  /**
+   * @return the number of DTOs the DAL left unreleased and that were
+   * released at the end of their transaction
+   */
+  public static long getLeakedCount() {
+    return leaked.get();
+  }
+
+  /**
+   * Starts tracking the DTOs of a new transaction.
+   */
+  void begin() {
+    transactionMode = mode;
+  }
+
+  void track(Object dto) {
+    if (transactionMode != Mode.OFF && dto != null) {
+      live.put(dto, transactionMode == Mode.DEBUG ?
+          new Throwable("DTO allocated here") : null);
+    }
+  }
+
+  void trackAll(Collection<?> dtos) {
+    if (transactionMode != Mode.OFF && dtos != null) {
+      for (Object dto : dtos) {
+        track(dto);
+      }
+    }
+  }
+
+  /**
+   * Stops tracking a DTO the DAL is releasing.
+   *
+   * @return false if the DTO was already released by the arena
+   */
+  boolean untrack(Object dto) {
+    if (!live.isEmpty()) {
+      live.remove(dto);
+    }
+    return retired.isEmpty() || !retired.remove(dto);
+  }
+
+  /**
+   * Ends the transaction.
+   *
+   * @return the DTOs that are still live and have to be released
+   */
+  List<Object> end() {
+    transactionMode = Mode.OFF;
+    if (live.isEmpty()) {
+      return Collections.emptyList();
+    }
+    List<Object> unreleased = new ArrayList<>(live.keySet());
+    leaked.addAndGet(unreleased.size());
+    if (LOG.isWarnEnabled()) {
+      for (Map.Entry<Object, Throwable> e : live.entrySet()) {
+        if (e.getValue() != null) {
+          LOG.warn("Unreleased " + dtoName(e.getKey()) +
+              " at the end of the transaction", e.getValue());
+        }
+      }
+    }
+    retired.clear();
+    retired.addAll(unreleased);
+    live.clear();
+    return unreleased;
+  }
+
+  /**
+   * Ends the transaction, if any, and forgets the retired DTOs as the
+   * session is closing.
+   *
+   * @return the DTOs that are still live and have to be released
+   */
+  List<Object> close() {
+    List<Object> unreleased = end();
+    retired.clear();
+    return unreleased;
+  }
+
+  private static String dtoName(Object dto) {
+    Class<?>[] interfaces = dto.getClass().getInterfaces();
+    return interfaces.length > 0 ? interfaces[0].getName() :
+        dto.getClass().getName();
+  }
+}
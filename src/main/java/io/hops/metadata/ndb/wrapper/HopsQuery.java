@@ -28,9 +28,15 @@ import java.util.Map;
 
 public class HopsQuery<E> {
   private final Query<E> query;
+  private final HopsSession session;
 
   public HopsQuery(Query<E> query) {
+    this(query, null);
+  }
+
+  HopsQuery(Query<E> query, HopsSession session) {
     this.query = query;
+    this.session = session;
   }
 
   public void setParameter(String s, Object o) throws StorageException {
@@ -43,7 +49,11 @@ public class HopsQuery<E> {
 
   public List<E> getResultList() throws StorageException {
     try {
-      return query.getResultList();
+      List<E> results = query.getResultList();
+      if (session != null) {
+        session.track(results);
+      }
+      return results;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
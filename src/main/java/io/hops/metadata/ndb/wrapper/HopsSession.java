@@ -25,11 +25,19 @@ import com.mysql.clusterj.Session;
 import com.mysql.clusterj.Transaction;
 import com.mysql.clusterj.query.QueryBuilder;
 import io.hops.exception.StorageException;
+import java.util.ArrayList;
 import java.util.Collection;
+import java.util.List;
 
 public class HopsSession {
   private final Session session;
   private LockMode lockMode = LockMode.READ_COMMITTED;
+  // write operations defined in the current transaction since the last
+  // flush or commit
+  private int pendingWrites = 0;
+  private final DTOArena arena = new DTOArena();
+  // run when the current transaction ends
+  private final List<Runnable> afterTransaction = new ArrayList<>();
 
   public HopsSession(Session session) {
     this.session = session;
@@ -49,7 +57,7 @@ public class HopsSession {
     try {
       Query<T> query =
           session.createQuery(queryDefinition.getQueryDomainType());
-      return new HopsQuery<>(query);
+      return new HopsQuery<>(query, this);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -57,7 +65,9 @@ public class HopsSession {
 
   public <T> T find(Class<T> aClass, Object o) throws StorageException {
     try {
-      return session.find(aClass, o);
+      T found = session.find(aClass, o);
+      arena.track(found);
+      return found;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -65,7 +75,9 @@ public class HopsSession {
 
   public <T> T newInstance(Class<T> aClass) throws StorageException {
     try {
-      return session.newInstance(aClass);
+      T instance = session.newInstance(aClass);
+      arena.track(instance);
+      return instance;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -73,7 +85,9 @@ public class HopsSession {
 
   public <T> T newInstance(Class<T> aClass, Object o) throws StorageException {
     try {
-      return session.newInstance(aClass, o);
+      T instance = session.newInstance(aClass, o);
+      arena.track(instance);
+      return instance;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -81,7 +95,9 @@ public class HopsSession {
 
   public <T> T makePersistent(T t) throws StorageException {
     try {
-      return session.makePersistent(t);
+      T persisted = session.makePersistent(t);
+      countWrites(1);
+      return persisted;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -106,6 +122,7 @@ public class HopsSession {
   public void persist(Object o) throws StorageException {
     try {
       session.persist(o);
+      countWrites(1);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -114,7 +131,9 @@ public class HopsSession {
   public Iterable<?> makePersistentAll(Iterable<?> iterable)
       throws StorageException {
     try {
-      return session.makePersistentAll(iterable);
+      Iterable<?> persisted = session.makePersistentAll(iterable);
+      countWrites(count(iterable));
+      return persisted;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -124,6 +143,7 @@ public class HopsSession {
       throws StorageException {
     try {
       session.deletePersistent(aClass, o);
+      countWrites(1);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -132,6 +152,7 @@ public class HopsSession {
   public void deletePersistent(Object o) throws StorageException {
     try {
       session.deletePersistent(o);
+      countWrites(1);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -140,6 +161,7 @@ public class HopsSession {
   public void remove(Object o) throws StorageException {
     try {
       session.remove(o);
+      countWrites(1);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -157,6 +179,7 @@ public class HopsSession {
       throws StorageException {
     try {
       session.deletePersistentAll(iterable);
+      countWrites(count(iterable));
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -165,6 +188,7 @@ public class HopsSession {
   public void updatePersistent(Object o) throws StorageException {
     try {
       session.updatePersistent(o);
+      countWrites(1);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -174,6 +198,7 @@ public class HopsSession {
       throws StorageException {
     try {
       session.updatePersistentAll(iterable);
+      countWrites(count(iterable));
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -181,7 +206,9 @@ public class HopsSession {
 
   public <T> T savePersistent(T t) throws StorageException {
     try {
-      return session.savePersistent(t);
+      T persisted = session.savePersistent(t);
+      countWrites(1);
+      return persisted;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -190,7 +217,9 @@ public class HopsSession {
   public Iterable<?> savePersistentAll(Iterable<?> iterable)
       throws StorageException {
     try {
-      return session.savePersistentAll(iterable);
+      Iterable<?> persisted = session.savePersistentAll(iterable);
+      countWrites(count(iterable));
+      return persisted;
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -199,15 +228,23 @@ public class HopsSession {
   public HopsTransaction currentTransaction() throws StorageException {
     try {
       Transaction transaction = session.currentTransaction();
-      return new HopsTransaction(transaction);
+      return new HopsTransaction(transaction, this);
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
   }
 
   public void close() throws StorageException {
+    runAfterTransaction();
     try {
-      session.close();
+      try {
+        // the DTOs of a transaction whose commit failed
+        for (Object dto : arena.close()) {
+          session.release(dto);
+        }
+      } finally {
+        session.close();
+      }
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -224,6 +261,7 @@ public class HopsSession {
   public void flush() throws StorageException {
     try {
       session.flush();
+      writesExecuted();
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -265,7 +303,7 @@ public class HopsSession {
   
   public <T> void release(T t)  throws StorageException {
     try {
-      if(t!=null){
+      if(t!=null && arena.untrack(t)){
         session.release(t);
       }
     } catch (ClusterJException e) {
@@ -277,7 +315,9 @@ public class HopsSession {
     try {
       if(t!=null){
         for(T dto : t)  {
-          session.release(dto);
+          if (arena.untrack(dto)) {
+            session.release(dto);
+          }
         }
       }
     } catch (ClusterJException e) {
@@ -288,4 +328,91 @@ public class HopsSession {
   public LockMode getCurrentLockMode(){
     return lockMode;
   }
+
+  void transactionBegun() throws StorageException {
+    // a transaction whose commit failed and was never rolled back
+    transactionEnded();
+    arena.begin();
+    pendingWrites = 0;
+  }
+
+  /**
+   * Runs the action once the current transaction has committed or rolled
+   * back, or right away if no transaction is active. Caches of rows written
+   * by the transaction are invalidated this way, so that a concurrent reader
+   * cannot reload the rows from before the commit once the invalidation is
+   * done. Running the action after a rollback too drops what the transaction
+   * may have cached from its own uncommitted writes.
+   */
+  public void afterTransaction(Runnable action) throws StorageException {
+    if (currentTransaction().isActive()) {
+      afterTransaction.add(action);
+    } else {
+      action.run();
+    }
+  }
+
+  /**
+   * Releases the DTOs of the transaction that the DAL did not release and
+   * runs the actions registered with {@link #afterTransaction(Runnable)}.
+   */
+  void transactionEnded() throws StorageException {
+    List<Object> unreleased = arena.end();
+    try {
+      for (Object dto : unreleased) {
+        session.release(dto);
+      }
+    } catch (ClusterJException e) {
+      throw HopsExceptionHelper.wrap(e);
+    } finally {
+      runAfterTransaction();
+    }
+  }
+
+  private void runAfterTransaction() {
+    if (afterTransaction.isEmpty()) {
+      return;
+    }
+    List<Runnable> actions = new ArrayList<>(afterTransaction);
+    afterTransaction.clear();
+    for (Runnable action : actions) {
+      action.run();
+    }
+  }
+
+  <T> void track(List<T> dtos) {
+    arena.trackAll(dtos);
+  }
+
+  /**
+   * Writes outside a transaction are executed one at a time as they are
+   * defined, so only the writes of a transaction make up a batch.
+   */
+  private void countWrites(int writes) {
+    if (session.currentTransaction().isActive()) {
+      pendingWrites += writes;
+    }
+  }
+
+  void writesExecuted() {
+    if (pendingWrites > 0) {
+      WriteBatchStats.getInstance().executed(pendingWrites);
+      pendingWrites = 0;
+    }
+  }
+
+  void writesDiscarded() {
+    pendingWrites = 0;
+  }
+
+  private static int count(Iterable<?> iterable) {
+    if (iterable instanceof Collection) {
+      return ((Collection<?>) iterable).size();
+    }
+    int count = 0;
+    for (Object o : iterable) {
+      count++;
+    }
+    return count;
+  }
 }
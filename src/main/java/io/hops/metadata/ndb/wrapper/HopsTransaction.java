@@ -24,14 +24,23 @@ import io.hops.exception.StorageException;
 
 public class HopsTransaction {
   private final Transaction transaction;
+  private final HopsSession session;
 
   public HopsTransaction(Transaction transaction) {
+    this(transaction, null);
+  }
+
+  HopsTransaction(Transaction transaction, HopsSession session) {
     this.transaction = transaction;
+    this.session = session;
   }
 
   public void begin() throws StorageException {
     try {
       transaction.begin();
+      if (session != null) {
+        session.transactionBegun();
+      }
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -40,6 +49,10 @@ public class HopsTransaction {
   public void commit() throws StorageException {
     try {
       transaction.commit();
+      if (session != null) {
+        session.writesExecuted();
+        session.transactionEnded();
+      }
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
@@ -48,6 +61,10 @@ public class HopsTransaction {
   public void rollback() throws StorageException {
     try {
       transaction.rollback();
+      if (session != null) {
+        session.writesDiscarded();
+        session.transactionEnded();
+      }
     } catch (ClusterJException e) {
       throw HopsExceptionHelper.wrap(e);
     }
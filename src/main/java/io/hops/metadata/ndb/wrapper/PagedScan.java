@@ -0,0 +1,139 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.wrapper;
+
+import com.mysql.clusterj.Query;
+import io.hops.exception.StorageException;
+
+import java.util.List;
+
+/**
+ * Reads a whole table in pages of at most pageSize rows, ordered on an index
+ * and resumed after the key of the last row of the previous page. Only one
+ * page of DTOs is held at a time, so the memory used does not grow with the
+ * table.
+ * <p/>
+ * The key fields must be the leading columns of an ordered index, usually the
+ * primary key, and must identify a row. Rows inserted behind the scan
+ * position while it runs are not seen.
+ */
+public abstract class PagedScan<E> {
+
+  public static final int DEFAULT_PAGE_SIZE = 1000;
+
+  public interface RowHandler<E> {
+    void handle(E row) throws StorageException;
+  }
+
+  private final Class<E> type;
+  private final int pageSize;
+  private final String[] keyFields;
+
+  protected PagedScan(Class<E> type, String... keyFields) {
+    this(type, DEFAULT_PAGE_SIZE, keyFields);
+  }
+
+  protected PagedScan(Class<E> type, int pageSize, String... keyFields) {
+    if (pageSize <= 0 || keyFields.length == 0) {
+      throw new IllegalArgumentException("a paged scan needs a positive " +
+          "page size and at least one key field");
+    }
+    this.type = type;
+    this.pageSize = pageSize;
+    this.keyFields = keyFields;
+  }
+
+  /**
+   * @return the values of the key fields of the row, in order
+   */
+  protected abstract Object[] key(E row);
+
+  /**
+   * Hands the rows to the handler one at a time. The rows of a page are
+   * released once the handler is done with them, so the handler must not keep
+   * them.
+   *
+   * @return the number of rows handled
+   */
+  public int scan(HopsSession session, RowHandler<E> handler)
+      throws StorageException {
+    int rows = 0;
+    Object[] last = null;
+    while (true) {
+      List<E> page = readPage(session, last);
+      try {
+        for (E row : page) {
+          handler.handle(row);
+          rows++;
+        }
+        if (page.size() < pageSize) {
+          return rows;
+        }
+        last = key(page.get(page.size() - 1));
+      } finally {
+        session.release(page);
+      }
+    }
+  }
+
+  private List<E> readPage(HopsSession session, Object[] after)
+      throws StorageException {
+    HopsQueryBuilder qb = session.getQueryBuilder();
+    HopsQueryDomainType<E> dobj = qb.createQueryDefinition(type);
+    if (after != null) {
+      dobj.where(after(dobj));
+    }
+    HopsQuery<E> query = session.createQuery(dobj);
+    if (after != null) {
+      for (int i = 0; i < keyFields.length; i++) {
+        query.setParameter(param(i), after[i]);
+      }
+    }
+    query.setOrdering(Query.Ordering.ASCENDING, keyFields);
+    query.setLimits(0, pageSize);
+    return query.getResultList();
+  }
+
+  /**
+   * (k0, .., kn) > (p0, .., pn), with k0 >= p0 first so that the scan starts
+   * at the last position instead of filtering the whole index.
+   */
+  private HopsPredicate after(HopsQueryDomainType<E> dobj)
+      throws StorageException {
+    if (keyFields.length == 1) {
+      return dobj.get(keyFields[0]).greaterThan(dobj.param(param(0)));
+    }
+    HopsPredicate bound = dobj.get(keyFields[0])
+        .greaterEqual(dobj.param(param(0)));
+    HopsPredicate greater = null;
+    for (int i = 0; i < keyFields.length; i++) {
+      HopsPredicate term =
+          dobj.get(keyFields[i]).greaterThan(dobj.param(param(i)));
+      for (int j = 0; j < i; j++) {
+        term = dobj.get(keyFields[j]).equal(dobj.param(param(j))).and(term);
+      }
+      greater = greater == null ? term : greater.or(term);
+    }
+    return bound.and(greater);
+  }
+
+  private static String param(int i) {
+    return "key" + i;
+  }
+}
@@ -0,0 +1,79 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.metadata.ndb.wrapper;
+
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Process wide counters of the write operations sent to the data nodes per
+ * execute, that is per flush or commit of a session that had pending writes.
+ * Writes defined by the prepare() of every DAL touched by a transaction are
+ * sent together at commit, unless a DAL flushes early, so a low number of
+ * operations per execute points to early flushes.
+ */
+public class WriteBatchStats {
+
+  private static final WriteBatchStats INSTANCE = new WriteBatchStats();
+
+  private final AtomicLong executes = new AtomicLong(0);
+  private final AtomicLong operations = new AtomicLong(0);
+  private final AtomicLong maxOperationsPerExecute = new AtomicLong(0);
+
+  private WriteBatchStats() {
+  }
+
+  public static WriteBatchStats getInstance() {
+    return INSTANCE;
+  }
+
+  void executed(int batchOperations) {
+    executes.incrementAndGet();
+    operations.addAndGet(batchOperations);
+    long max;
+    do {
+      max = maxOperationsPerExecute.get();
+    } while (batchOperations > max &&
+        !maxOperationsPerExecute.compareAndSet(max, batchOperations));
+  }
+
+  public long getExecutes() {
+    return executes.get();
+  }
+
+  public long getOperations() {
+    return operations.get();
+  }
+
+  public long getMaxOperationsPerExecute() {
+    return maxOperationsPerExecute.get();
+  }
+
+  public double getAverageOperationsPerExecute() {
+    long count = executes.get();
+    return count == 0 ? 0 : (double) operations.get() / count;
+  }
+
+  @Override
+  public String toString() {
+    return "write batches: executes=" + getExecutes() + " operations=" +
+        getOperations() + " avg ops/execute=" +
+        String.format("%.2f", getAverageOperationsPerExecute()) +
+        " max ops/execute=" + getMaxOperationsPerExecute();
+  }
+}
@@ -0,0 +1,260 @@
+/*
+ * Hops Database abstraction layer for storing the hops metadata in MySQL Cluster
+ * Copyright (C) 2015  hops.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+package io.hops.util;
+
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * Open addressing (linear probing) map from primitive long to primitive long.
+ * Used by the bulk block queries so that millions of (blockId, inodeId) pairs
+ * do not cost a boxed Long pair and a HashMap entry each.
+ * <p/>
+ * Not thread safe.
+ */
+public class LongLongHashMap {
+
+  private static final long FREE_KEY = 0L;
+  private static final float LOAD_FACTOR = 0.75f;
+  private static final int MIN_CAPACITY = 16;
+
+  private long[] keys;
+  private long[] values;
+  private int mask;
+  private int size;
+  private int resizeAt;
+
+  // FREE_KEY marks empty slots, so a mapping for it is kept on the side
+  private boolean hasFreeKey;
+  private long freeKeyValue;
+
+  public LongLongHashMap() {
+    this(MIN_CAPACITY);
+  }
+
+  public LongLongHashMap(int expectedSize) {
+    allocate(capacityFor(expectedSize));
+  }
+
+  public int size() {
+    return size;
+  }
+
+  public boolean isEmpty() {
+    return size == 0;
+  }
+
+  /**
+   * @return the previous value mapped to key or defaultValue if there was none
+   */
+  public long put(long key, long value, long defaultValue) {
+    if (key == FREE_KEY) {
+      long prev = hasFreeKey ? freeKeyValue : defaultValue;
+      if (!hasFreeKey) {
+        hasFreeKey = true;
+        size++;
+      }
+      freeKeyValue = value;
+      return prev;
+    }
+    int slot = slot(key);
+    while (keys[slot] != FREE_KEY) {
+      if (keys[slot] == key) {
+        long prev = values[slot];
+        values[slot] = value;
+        return prev;
+      }
+      slot = (slot + 1) & mask;
+    }
+    keys[slot] = key;
+    values[slot] = value;
+    if (++size >= resizeAt) {
+      rehash(keys.length << 1);
+    }
+    return defaultValue;
+  }
+
+  public void put(long key, long value) {
+    put(key, value, 0L);
+  }
+
+  public long get(long key, long defaultValue) {
+    if (key == FREE_KEY) {
+      return hasFreeKey ? freeKeyValue : defaultValue;
+    }
+    int slot = slot(key);
+    long k;
+    while ((k = keys[slot]) != FREE_KEY) {
+      if (k == key) {
+        return values[slot];
+      }
+      slot = (slot + 1) & mask;
+    }
+    return defaultValue;
+  }
+
+  public boolean containsKey(long key) {
+    if (key == FREE_KEY) {
+      return hasFreeKey;
+    }
+    int slot = slot(key);
+    long k;
+    while ((k = keys[slot]) != FREE_KEY) {
+      if (k == key) {
+        return true;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return false;
+  }
+
+  public void clear() {
+    Arrays.fill(keys, FREE_KEY);
+    size = 0;
+    hasFreeKey = false;
+  }
+
+  /**
+   * Copies the keys into a new array, in the same order as
+   * {@link #valuesArray()}.
+   */
+  public long[] keysArray() {
+    long[] result = new long[size];
+    int i = 0;
+    if (hasFreeKey) {
+      result[i++] = FREE_KEY;
+    }
+    for (int slot = 0; slot < keys.length; slot++) {
+      if (keys[slot] != FREE_KEY) {
+        result[i++] = keys[slot];
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Copies the values into a new array, in the same order as
+   * {@link #keysArray()}.
+   */
+  public long[] valuesArray() {
+    long[] result = new long[size];
+    int i = 0;
+    if (hasFreeKey) {
+      result[i++] = freeKeyValue;
+    }
+    for (int slot = 0; slot < keys.length; slot++) {
+      if (keys[slot] != FREE_KEY) {
+        result[i++] = values[slot];
+      }
+    }
+    return result;
+  }
+
+  public Cursor cursor() {
+    return new Cursor();
+  }
+
+  /**
+   * Boxes the content into a java.util.Map. Only meant for callers that still
+   * use the Map based DAL API.
+   */
+  public Map<Long, Long> toMap() {
+    Map<Long, Long> map = new HashMap<>(size);
+    Cursor cursor = cursor();
+    while (cursor.next()) {
+      map.put(cursor.key(), cursor.value());
+    }
+    return map;
+  }
+
+  /**
+   * Iterates over the entries without allocating per entry.
+   * <pre>
+   *   LongLongHashMap.Cursor c = map.cursor();
+   *   while (c.next()) { use(c.key(), c.value()); }
+   * </pre>
+   */
+  public class Cursor {
+    private int slot = hasFreeKey ? -2 : -1;
+
+    public boolean next() {
+      if (slot == -2) {
+        slot = -1;
+        return true;
+      }
+      while (++slot < keys.length) {
+        if (keys[slot] != FREE_KEY) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    public long key() {
+      return slot == -1 ? FREE_KEY : keys[slot];
+    }
+
+    public long value() {
+      return slot == -1 ? freeKeyValue : values[slot];
+    }
+  }
+
+  private int slot(long key) {
+    long h = key * 0x9E3779B97F4A7C15L;
+    return (int) (h ^ (h >>> 32)) & mask;
+  }
+
+  private void rehash(int newCapacity) {
+    long[] oldKeys = keys;
+    long[] oldValues = values;
+    allocate(newCapacity);
+    for (int i = 0; i < oldKeys.length; i++) {
+      long key = oldKeys[i];
+      if (key != FREE_KEY) {
+        int slot = slot(key);
+        while (keys[slot] != FREE_KEY) {
+          slot = (slot + 1) & mask;
+        }
+        keys[slot] = key;
+        values[slot] = oldValues[i];
+      }
+    }
+  }
+
+  private void allocate(int capacity) {
+    keys = new long[capacity];
+    values = new long[capacity];
+    mask = capacity - 1;
+    resizeAt = (int) (capacity * LOAD_FACTOR);
+  }
+
+  private static int capacityFor(int expectedSize) {
+    long required = (long) Math.ceil(Math.max(expectedSize, 1) / LOAD_FACTOR) + 1;
+    if (required > (1 << 30)) {
+      throw new IllegalArgumentException(
+          "Too many entries for LongLongHashMap: " + expectedSize);
+    }
+    int capacity = MIN_CAPACITY;
+    while (capacity < required) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+}